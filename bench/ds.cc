@@ -0,0 +1,343 @@
+/*
+  Microbenchmarks for the ds.cc containers and the mem allocator, on workloads shaped like
+  the compiler's: identifier keys, push heavy token arrays and AST sized arena bumps.
+  Every benchmark runs RUNS times and the fastest run is reported as csv on stdout:
+    benchmark,ops,ns_per_op,allocs,cache_misses
+  allocs counts the pool allocations and arena bumps mem handed out during the run(MEM_COUNT,
+  turned on below). cache_misses is -1 when
+  hardware counters are not available(not linux, or perf_event_paranoid forbids them).
+  usage:
+    $CXX bench/ds.cc -O2 -march=native -o bin/bench/ds.o -D LIN=1 -D SIMD=1
+    bin/bench/ds.o [filter]     //only benchmarks whose name contains filter
+*/
+#if(__clang__)
+#pragma clang diagnostic ignored "-Wwritable-strings"
+#pragma clang diagnostic ignored "-Wswitch"
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+#pragma clang diagnostic ignored "-Wmicrosoft-include"
+#pragma clang diagnostic ignored "-Wmicrosoft-goto"
+#endif
+
+#define MEM_COUNT 1
+#include "../src/include.hh"
+#include <time.h>
+#if(LIN)
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#define RUNS        5
+#define TOKENS      1000000     //tokens of a large source file
+#define IDENTS      300000      //identifier occurrences
+#define DISTINCT    20000       //distinct identifiers among them
+#define AST_NODES   1000000
+#define PROCS       20000
+#define PROC_VARS   40
+
+u64 nowNs(){
+#if(WIN)
+    LARGE_INTEGER freq, t;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&t);
+    return (u64)((f64)t.QuadPart * 1000000000.0 / (f64)freq.QuadPart);
+#else
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (u64)t.tv_sec*1000000000 + t.tv_nsec;
+#endif
+};
+
+namespace counter{
+    s32 fd = -1;
+    void init(){
+#if(LIN)
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = (s32)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    };
+    s64 read(){
+        if(fd < 0){return -1;};
+        u64 value;
+#if(LIN)
+        if(::read(fd, &value, sizeof(value)) != sizeof(value)){return -1;};
+#endif
+        return (s64)value;
+    };
+};
+
+//deterministic xorshift, so every commit benchmarks the same keys
+u64 rngState = 0x9E3779B97F4A7C15ull;
+u32 rng(){
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return (u32)(rngState >> 32);
+};
+
+//identifiers like the ones in source files: loop counters, short names, camelCase and snake_case
+static DynamicArray<String> names;      //distinct
+static DynamicArray<String> idents;     //occurrences, frequent names repeat more
+void genIdentifiers(){
+    static const char *words[] = {"count", "index", "node", "value", "token", "type", "scope", "size", "offset",
+                                  "lexer", "file", "buffer", "entity", "result", "temp", "start", "end", "len"};
+    const u32 wordCount = sizeof(words)/sizeof(words[0]);
+    names.init(DISTINCT);
+    char *buff = (char*)mem::alloc(DISTINCT * 48);
+    u32 off = 0;
+    for(u32 x=0; x<DISTINCT; x++){
+        char *name = buff + off;
+        s32 len;
+        switch(rng() % 4){
+            case 0: len = snprintf(name, 48, "%c%u", 'a' + rng()%26, x); break;
+            case 1: len = snprintf(name, 48, "%s%u", words[rng()%wordCount], x); break;
+            case 2: len = snprintf(name, 48, "%s%c%s%u", words[rng()%wordCount], 'A' + rng()%26, words[rng()%wordCount], x); break;
+            default: len = snprintf(name, 48, "%s_%s_%s_%u", words[rng()%wordCount], words[rng()%wordCount], words[rng()%wordCount], x); break;
+        };
+        names.push({name, (u32)len});
+        off += len + 1;
+    };
+    idents.init(IDENTS);
+    for(u32 x=0; x<IDENTS; x++){
+        //squaring a uniform pick favours the low ids, a rough zipf
+        u64 r = rng() % DISTINCT;
+        idents.push(names[(u32)((r * r) / DISTINCT)]);
+    };
+};
+
+typedef u64 (*BenchProc)();     //runs the workload once and returns the ops it did
+struct Bench{
+    const char *name;
+    BenchProc proc;
+};
+
+u32 sink;
+
+u64 dynarrayPushTokTypes(){
+    DynamicArray<TokType> types;
+    types.init();
+    for(u32 x=0; x<TOKENS; x++){types.push((TokType)(x & 127));};
+    sink += (u32)types[types.count-1];
+    types.uninit();
+    return TOKENS;
+};
+u64 dynarrayPushTokOffs(){
+    DynamicArray<u32> offs;
+    offs.init();
+    for(u32 x=0; x<TOKENS; x++){offs.push(x*4);};
+    sink += offs[offs.count-1];
+    offs.uninit();
+    return TOKENS;
+};
+u64 dynarrayPushArena(){
+    mem::Arena arena;
+    arena.init();
+    DynamicArray<u32> offs;
+    offs.init(5, &arena);
+    for(u32 x=0; x<TOKENS; x++){offs.push(x*4);};
+    sink += offs[offs.count-1];
+    arena.uninit();
+    return TOKENS;
+};
+u64 hashmapStrIntern(){
+    HashmapStr map;
+    map.init();
+    for(u32 x=0; x<idents.count; x++){
+        u32 id;
+        if(!map.getValue(idents[x], &id)){map.insertValue(idents[x], map.count);};
+    };
+    sink += map.count;
+    map.uninit();
+    return idents.count;
+};
+u64 hashmapStrLookup(){
+    static HashmapStr map;
+    static bool filled = false;
+    if(!filled){
+        map.init(names.count);
+        for(u32 x=0; x<names.count; x++){map.insertValue(names[x], x);};
+        filled = true;
+    };
+    for(u32 x=0; x<idents.count; x++){
+        u32 id = 0;
+        map.getValue(idents[x], &id);
+        sink += id;
+    };
+    return idents.count;
+};
+u64 hashmapSymInsert(){
+    Hashmap<u32, u32> map;
+    map.init();
+    for(u32 x=0; x<DISTINCT; x++){map.insertValue(x*7 + 1, x);};
+    sink += map.count;
+    map.uninit();
+    return DISTINCT;
+};
+u64 hashmapSymLookup(){
+    static Hashmap<u32, u32> map;
+    static bool filled = false;
+    if(!filled){
+        map.init(DISTINCT);
+        for(u32 x=0; x<DISTINCT; x++){map.insertValue(x*7 + 1, x);};
+        filled = true;
+    };
+    //half of the lookups miss
+    for(u32 x=0; x<IDENTS; x++){
+        u32 off = 0;
+        map.getValue((rng() % (DISTINCT*2))*7 + 1, &off);
+        sink += off;
+    };
+    return IDENTS;
+};
+u64 hashmapPtrLookup(){
+    static Hashmap<void*, u64> map;
+    static void **ptrs;
+    if(ptrs == nullptr){
+        ptrs = (void**)mem::alloc(sizeof(void*) * DISTINCT);
+        map.init(DISTINCT);
+        for(u32 x=0; x<DISTINCT; x++){
+            ptrs[x] = mem::alloc(32);
+            map.insertValue(ptrs[x], x);
+        };
+    };
+    for(u32 x=0; x<IDENTS; x++){
+        u64 value = 0;
+        map.getValue(ptrs[rng() % DISTINCT], &value);
+        sink += (u32)value;
+    };
+    return IDENTS;
+};
+//a procedure's locals: fill, look each up twice, clear for the next procedure
+u64 genHashmapClear(){
+    GenHashmap<u32, u32> map;
+    map.init();
+    for(u32 p=0; p<PROCS; p++){
+        for(u32 v=0; v<PROC_VARS; v++){map.insertValue(p*PROC_VARS + v, v);};
+        for(u32 v=0; v<PROC_VARS*2; v++){
+            u32 off = 0;
+            map.getValue(p*PROC_VARS + v/2, &off);
+            sink += off;
+        };
+        map.clear();
+    };
+    map.uninit();
+    return PROCS * PROC_VARS * 3;
+};
+//a sliding window of live small objects, freed oldest first
+u64 allocFreeSmall(){
+    const u32 window = 64;
+    void *live[window] = {};
+    for(u32 x=0; x<AST_NODES; x++){
+        u32 slot = x % window;
+        if(live[slot]){mem::free(live[slot]);};
+        live[slot] = mem::alloc(8 + (rng() % 249));
+    };
+    for(u32 x=0; x<window; x++){
+        if(live[x]){mem::free(live[x]);};
+    };
+    return AST_NODES;
+};
+//the DynamicArray pattern: one buffer growing by 1.5x
+u64 allocGrow(){
+    u32 ops = 0;
+    for(u32 r=0; r<100; r++){
+        u64 size = 16;
+        void *ptr = mem::alloc(size);
+        while(size < 1<<20){
+            u64 newSize = size + size/2;
+            if(!mem::tryExtend(ptr, newSize)){
+                void *newPtr = mem::alloc(newSize);
+                memcpy(newPtr, ptr, size);
+                mem::free(ptr);
+                ptr = newPtr;
+            };
+            size = newSize;
+            ops += 1;
+        };
+        mem::free(ptr);
+    };
+    return ops;
+};
+//parser nodes are 24 to 64 bytes and die together
+u64 arenaAstBump(){
+    static mem::Arena arena;
+    static bool inited = false;
+    if(!inited){
+        arena.init(AST_PAGE_SIZE);
+        inited = true;
+    };
+    static const u32 sizes[] = {24, 32, 40, 48, 64};
+    for(u32 x=0; x<AST_NODES; x++){
+        u64 *node = (u64*)arena.alloc(sizes[x % 5]);
+        node[0] = x;
+    };
+    arena.reset();
+    return AST_NODES;
+};
+u64 slabPoolNewElem(){
+    SlabPool<VariableEntity> pool;
+    pool.init();
+    for(u32 x=0; x<AST_NODES; x++){
+        VariableEntity *entity = pool.newElem();
+        entity->size = x;
+    };
+    pool.uninit();
+    return AST_NODES;
+};
+
+static Bench benches[] = {
+    {"dynarray_push_toktype",  dynarrayPushTokTypes},
+    {"dynarray_push_tokoff",   dynarrayPushTokOffs},
+    {"dynarray_push_arena",    dynarrayPushArena},
+    {"hashmapstr_intern",      hashmapStrIntern},
+    {"hashmapstr_lookup",      hashmapStrLookup},
+    {"hashmap_sym_insert",     hashmapSymInsert},
+    {"hashmap_sym_lookup",     hashmapSymLookup},
+    {"hashmap_ptr_lookup",     hashmapPtrLookup},
+    {"genhashmap_clear_reuse", genHashmapClear},
+    {"alloc_free_small",       allocFreeSmall},
+    {"alloc_grow",             allocGrow},
+    {"arena_ast_bump",         arenaAstBump},
+    {"slabpool_newelem",       slabPoolNewElem},
+};
+
+s32 main(s32 argc, char **argv){
+    mem::init();
+    DEFER(mem::uninit());
+    char *filter = (argc > 1)?argv[1]:nullptr;
+    genIdentifiers();
+    counter::init();
+    printf("benchmark,ops,ns_per_op,allocs,cache_misses\n");
+    for(u32 b=0; b<sizeof(benches)/sizeof(benches[0]); b++){
+        Bench &bench = benches[b];
+        if(filter && strstr(bench.name, filter) == nullptr){continue;};
+        f64 best = 0;
+        u64 ops = 0;
+        u64 allocs = 0;
+        s64 misses = -1;
+        for(u32 r=0; r<RUNS; r++){
+            u64 allocStart = mem::localHeap->allocs;
+            s64 missStart = counter::read();
+            u64 start = nowNs();
+            u64 runOps = bench.proc();
+            u64 ns = nowNs() - start;
+            s64 missEnd = counter::read();
+            f64 perOp = (f64)ns / runOps;
+            if(r == 0 || perOp < best){
+                best = perOp;
+                ops = runOps;
+                allocs = mem::localHeap->allocs - allocStart;
+                misses = (missStart < 0 || missEnd < 0)?-1:missEnd - missStart;
+            };
+        };
+        printf("%s,%llu,%.3f,%llu,%lld\n", bench.name, ops, best, allocs, misses);
+    };
+    //keeps the work from being optimized away
+    fprintf(stderr, "checksum %u\n", sink);
+    return EXIT_SUCCESS;
+};
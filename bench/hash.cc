@@ -0,0 +1,110 @@
+/*
+  Hashes every identifier of the given sources(as the lexer sees them) with the old
+  byte-at-a-time FNV-1a and with hashString, then times cmpString against memcmp.
+  usage:
+    $CXX bench/hash.cc -O2 -march=native -o bin/bench/hash.o -D LIN=1 -D SIMD=1
+    bin/bench/hash.o file.zs [file.zs ...]
+*/
+#if(__clang__)
+#pragma clang diagnostic ignored "-Wwritable-strings"
+#pragma clang diagnostic ignored "-Wswitch"
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+#pragma clang diagnostic ignored "-Wmicrosoft-include"
+#pragma clang diagnostic ignored "-Wmicrosoft-goto"
+#endif
+
+#include "../src/include.hh"
+#include <time.h>
+
+#define ROUNDS 200
+
+u32 fnv1a(const char *mem, u32 len){
+    u32 h = 0x811c9dc5;
+    for(u32 i=0; i<len; i+=1){h = (h^mem[i]) * 0x01000193;};
+    return h;
+};
+u64 nowNs(){
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (u64)t.tv_sec*1000000000 + t.tv_nsec;
+};
+//distinct hashes among the distinct identifiers. Less than the identifier count means collisions
+u32 distinctHashes(u32 (*hash)(const char*, u32)){
+    Hashmap<u32, u32> seen;
+    seen.init(Symbol::names.count);
+    DEFER(seen.uninit());
+    for(u32 x=1; x<Symbol::names.count; x++){
+        String name = Symbol::name(x);
+        u32 h = hash(name.mem, name.len);
+        u32 val;
+        if(!seen.getValue(h, &val)) seen.insertValue(h, x);
+    };
+    return seen.count;
+};
+s32 main(s32 argc, char **argv){
+    mem::init();
+    if(argc < 2){
+        printf("usage: %s file.zs [file.zs ...]\n", argv[0]);
+        return EXIT_FAILURE;
+    };
+    Symbol::init();
+    sourceArena.init();
+    tokenArena.init();
+    DynamicArray<String> idents;     //every identifier occurrence
+    DynamicArray<String> interned;   //its interned copy
+    idents.init(1024);
+    interned.init(1024);
+    for(s32 x=1; x<argc; x++){
+        Lexer lexer;
+        if(!lexer.init(argv[x]) || !lexer.genTokens()){
+            report::flushReports();
+            printf("could not lex %s\n", argv[x]);
+            return EXIT_FAILURE;
+        };
+        for(u32 i=0; i<lexer.tokenTypes.count; i++){
+            if(lexer.tokenTypes[i] != TokType::IDENTIFIER) continue;
+            idents.push(makeStringFromTokOff(i, lexer));
+            interned.push(Symbol::name(getSymbol(i, lexer)));
+        };
+    };
+    if(idents.count == 0){
+        printf("no identifiers\n");
+        return EXIT_FAILURE;
+    };
+    u64 bytes = 0;
+    for(u32 x=0; x<idents.count; x++) bytes += idents[x].len;
+    printf("identifiers: %d(%d distinct), average length %.2f\n", idents.count, Symbol::names.count-1, (f64)bytes/idents.count);
+
+    f64 total = (f64)idents.count * ROUNDS;
+    u32 sink = 0;
+    u64 start = nowNs();
+    for(u32 r=0; r<ROUNDS; r++){
+        for(u32 x=0; x<idents.count; x++) sink += fnv1a(idents[x].mem, idents[x].len);
+    };
+    u64 fnvNs = nowNs() - start;
+    start = nowNs();
+    for(u32 r=0; r<ROUNDS; r++){
+        for(u32 x=0; x<idents.count; x++) sink += hashString(idents[x].mem, idents[x].len);
+    };
+    u64 hashNs = nowNs() - start;
+    printf("fnv1a:      %6.2f ns/key, %d distinct hashes\n", fnvNs/total, distinctHashes(fnv1a));
+    printf("hashString: %6.2f ns/key, %d distinct hashes\n", hashNs/total, distinctHashes(hashString));
+
+    //the compare a symbol lookup does on a hit
+    start = nowNs();
+    for(u32 r=0; r<ROUNDS; r++){
+        for(u32 x=0; x<idents.count; x++){
+            sink += idents[x].len == interned[x].len && memcmp(idents[x].mem, interned[x].mem, idents[x].len) == 0;
+        };
+    };
+    u64 memcmpNs = nowNs() - start;
+    start = nowNs();
+    for(u32 r=0; r<ROUNDS; r++){
+        for(u32 x=0; x<idents.count; x++) sink += cmpString(idents[x], interned[x]);
+    };
+    u64 cmpNs = nowNs() - start;
+    printf("memcmp:     %6.2f ns/key\n", memcmpNs/total);
+    printf("cmpString:  %6.2f ns/key\n", cmpNs/total);
+    printf("(checksum %d)\n", sink);
+    return EXIT_SUCCESS;
+};
@@ -0,0 +1,49 @@
+#!/bin/bash
+# Compares the normal pool against the HUGE_PAGES pool on a large generated source.
+# usage: bench/hugepages.sh [procs] [runs]
+# Reports wall time per run and, when perf is installed, dTLB misses.
+
+PROCS=${1:-20000}
+RUNS=${2:-5}
+CXX=${CXX:-clang++}
+OUT=bin/bench
+
+if [ ! -d "$OUT" ]; then
+    mkdir -p $OUT
+fi
+
+$CXX src/main.cc -O2 -march=native -o $OUT/zeus.o -D LIN=1 -D SIMD=1 || exit 1
+$CXX src/main.cc -O2 -march=native -o $OUT/zeus_huge.o -D LIN=1 -D SIMD=1 -D HUGE_PAGES=1 || exit 1
+
+awk -v procs=$PROCS 'BEGIN{
+    print "g0: u32 = 1"
+    for(p=0; p<procs; p++){
+        printf("proc%d :: proc(a%d: s32, b: u32) -> (u32){\n", p, p)
+        for(v=0; v<40; v++){
+            printf("    var_%d_%d : u32 = %d\n", p, v, v*3+1)
+            printf("    // comment %d\n", v)
+        }
+        printf("    if var_%d_1 {\n        z : u32 = 5\n        z = var_%d_2\n    }\n}\n", p, p)
+    }
+}' > $OUT/big.zs
+echo "source: $OUT/big.zs ($(wc -c < $OUT/big.zs) bytes)"
+if [ -r /sys/kernel/mm/transparent_hugepage/enabled ]; then
+    echo "thp: $(cat /sys/kernel/mm/transparent_hugepage/enabled)"
+fi
+
+for bin in zeus zeus_huge; do
+    best=""
+    for ((i=0; i<RUNS; i++)); do
+        rm -f $OUT/out.asm
+        start=$(date +%s%N)
+        $OUT/$bin.o $OUT/big.zs $OUT/out.asm > /dev/null
+        end=$(date +%s%N)
+        ms=$(( (end - start) / 1000000 ))
+        if [ -z "$best" ] || [ $ms -lt $best ]; then best=$ms; fi
+    done
+    echo "$bin: best of $RUNS runs ${best}ms"
+    if command -v perf > /dev/null; then
+        rm -f $OUT/out.asm
+        perf stat -x, -e dTLB-loads,dTLB-load-misses,dTLB-store-misses $OUT/$bin.o $OUT/big.zs $OUT/out.asm 2>&1 > /dev/null | cut -d, -f1,3 | sed "s/^/  /"
+    fi
+done
@@ -0,0 +1,66 @@
+/*
+  Lexer throughput: lexes every given source ROUNDS times and prints the best round.
+  Every round starts from an empty symbol table, so interning is always paid for
+  usage:
+    $CXX bench/lexer.cc -O2 -march=native -o bin/bench/lexer.o -D LIN=1 -D SIMD=1
+    bin/bench/lexer.o file.zs [file.zs ...]
+  bench/hugepages.sh leaves a large generated source in bin/bench/big.zs
+*/
+#if(__clang__)
+#pragma clang diagnostic ignored "-Wwritable-strings"
+#pragma clang diagnostic ignored "-Wswitch"
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+#pragma clang diagnostic ignored "-Wmicrosoft-include"
+#pragma clang diagnostic ignored "-Wmicrosoft-goto"
+#endif
+
+#include "../src/include.hh"
+#include <time.h>
+
+#define ROUNDS 10
+
+u64 nowNs(){
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (u64)t.tv_sec*1000000000 + t.tv_nsec;
+};
+s32 main(s32 argc, char **argv){
+    mem::init();
+    if(argc < 2){
+        printf("usage: %s file.zs [file.zs ...]\n", argv[0]);
+        return EXIT_FAILURE;
+    };
+    sourceArena.init();
+    tokenArena.init();
+    u64 best = 0;
+    u64 bytes = 0;
+    u32 tokens = 0;
+    for(u32 r=0; r<ROUNDS; r++){
+        u64 ns = 0;
+        bytes = 0;
+        tokens = 0;
+        Symbol::init();
+        for(s32 x=1; x<argc; x++){
+            Lexer lexer;
+            if(!lexer.init(argv[x])){
+                printf("could not read %s\n", argv[x]);
+                return EXIT_FAILURE;
+            };
+            u64 start = nowNs();
+            b32 ok = lexer.genTokens();
+            ns += nowNs() - start;
+            if(!ok){
+                report::flushReports();
+                printf("could not lex %s\n", argv[x]);
+                return EXIT_FAILURE;
+            };
+            bytes += strlen(lexer.fileContent);
+            tokens += lexer.tokenTypes.count;
+            lexer.uninit();
+        };
+        Symbol::uninit();
+        if(r == 0 || ns < best) best = ns;
+    };
+    printf("%llu bytes, %u tokens: %.3f ms, %.3f GB/s, %.2f ns/token\n", bytes, tokens, best/1e6, (f64)bytes/best, (f64)best/tokens);
+    return EXIT_SUCCESS;
+};
@@ -4,6 +4,29 @@ if [ ! -d "bin/lin/" ]; then
     mkdir bin/lin
 fi
 
+# ./build.sh bench: builds the benchmarks, prints the container/allocator numbers as csv,
+# then the hashing and lexer numbers for a generated source
+if [ "$1" == "bench" ]; then
+    mkdir -p bin/bench
+    clang++ bench/ds.cc -O2 -march=native -o bin/bench/ds.o -D LIN=1 -D SIMD=1 || exit 1
+    clang++ bench/hash.cc -O2 -march=native -o bin/bench/hash.o -D LIN=1 -D SIMD=1 || exit 1
+    clang++ bench/lexer.cc -O2 -march=native -o bin/bench/lexer.o -D LIN=1 -D SIMD=1 || exit 1
+    bin/bench/ds.o || exit 1
+    awk 'BEGIN{
+        for(p=0; p<2000; p++){
+            printf("proc%d :: proc(a%d: s32, b: u32) -> (u32){\n", p, p)
+            for(v=0; v<40; v++){
+                printf("    var_%d_%d : u32 = %d\n", p, v, v*3+1)
+                printf("    // comment %d\n", v)
+            }
+            printf("}\n")
+        }
+    }' > bin/bench/src.zs
+    bin/bench/hash.o bin/bench/src.zs || exit 1
+    bin/bench/lexer.o bin/bench/src.zs
+    exit $?
+fi
+
 clang++ src/main.cc -O2 -march=native -o bin/lin/zeus.o -D LIN=1 -D SIMD=1
 clang++ src/main.cc -o bin/lin/zeus_dbg.o -D LIN=1 -D SIMD=1 -D DBG=1
 
@@ -22,61 +22,196 @@ struct ProcEntity{
 };
 
 struct Scope{
-    HashmapStr var;
-    HashmapStr proc;
-    //no need to free them as they live for the entire lifetime
+    Hashmap<u32, u32> var;     //symbol to offset in vars
+    Hashmap<u32, u32> proc;    //symbol to offset in procs
+    //no need to free them as they live in an arena
     DynamicArray<VariableEntity*> vars;
     DynamicArray<ProcEntity*> procs;
+    mem::Arena *arena;
     ScopeType type;
 
-    void init(ScopeType stype){
+    //NOTE: most blocks declare nothing, so the tables are made on the first insert
+    void init(ScopeType stype, mem::Arena *a){
         type = stype;
-        var.init();
-        vars.init();
-        proc.init();
-        procs.init();
+        arena = a;
+        vars.zero();
+        procs.zero();
     };
     void uninit(){
-        vars.uninit();
-        var.uninit();
-        proc.uninit();
-        procs.uninit();
+        if(vars.len){
+            vars.uninit();
+            var.uninit();
+        };
+        if(procs.len){
+            proc.uninit();
+            procs.uninit();
+        };
+    };
+    VariableEntity *getVar(u32 sym){
+        u32 off;
+        if(vars.len == 0 || !var.getValue(sym, &off)) return nullptr;
+        return vars[off];
+    };
+    ProcEntity *getProc(u32 sym){
+        u32 off;
+        if(procs.len == 0 || !proc.getValue(sym, &off)) return nullptr;
+        return procs[off];
+    };
+    void addVar(u32 sym, VariableEntity *entity){
+        if(vars.len == 0){
+            var.init(10, arena);
+            vars.init(5, arena);
+        };
+        var.insertValue(sym, vars.count);
+        vars.push(entity);
+    };
+    void addProc(u32 sym, ProcEntity *entity){
+        if(procs.len == 0){
+            proc.init(10, arena);
+            procs.init(5, arena);
+        };
+        proc.insertValue(sym, procs.count);
+        procs.push(entity);
     };
 };
 
-static Scope *globalScopes;                //all file scopes
-static Scope *structScopeAllocMem;         //struct scopes
-static Scope *scopeAllocMem;               //all scopes except file and struct
-static u32 scopeOff = 0;                   //how many total scopes except file and struct
-static u32 structScopeOff = 0;             //how many struct scopes
-static HashmapStr struc;                   //all structs name to off
+static Scope *globalScopes;                           //all file scopes
+static mem::Arena checkerArena;                       //tables of file and struct scopes. Lives till lowering is done
+static SlabPool<VariableEntity> varEntityPool;        //lives till lowering is done
+static SlabPool<ProcEntity> procEntityPool;           //lives till lowering is done
+static SlabPool<Scope, 16> structScopePool;           //lives till lowering is done
+static Hashmap<u32, u32> struc;            //all structs symbol to off
 static DynamicArray<StructEntity> strucs;  //all structs
 
-VariableEntity *getVariableEntity(ASTBase *node, DynamicArray<Scope*> &scopes){
-    String name;
+#define NO_BINDING 0xFFFFFFFF
+struct Binding{
+    void *entity;       //VariableEntity or ProcEntity
+    u32 sym;
+    u32 shadowed;       //binding of the same name that this one hides
+    u32 depth;          //frame the binding was made in
+    bool isProc;
+};
+struct ScopeFrame{
+    Scope *record;      //file and struct scopes also keep their names in a Scope
+    u32 start;          //bindings made before entering the frame
+    ScopeType type;
+};
+/*
+  Every name visible while checking, in one table indexed by symbol id.
+  A slot holds the innermost binding of the name, which chains to the binding it shadows.
+  Lookups are an array access no matter how deep the nesting is, and leaving a frame
+  unwinds the bindings it made
+*/
+struct SymbolTable{
+    DynamicArray<u32> vars;            //symbol to innermost variable binding
+    DynamicArray<u32> procs;           //symbol to innermost procedure binding
+    DynamicArray<Binding> bindings;    //in the order they were made
+    DynamicArray<ScopeFrame> frames;
+
+    void init(u32 symbolCount){
+        vars.init(symbolCount);
+        procs.init(symbolCount);
+        vars.count = symbolCount;
+        procs.count = symbolCount;
+        memset(vars.mem, 0xFF, sizeof(u32)*symbolCount);
+        memset(procs.mem, 0xFF, sizeof(u32)*symbolCount);
+        bindings.init(64);
+        frames.init(16);
+    };
+    void uninit(){
+        vars.uninit();
+        procs.uninit();
+        bindings.uninit();
+        frames.uninit();
+    };
+    ScopeFrame &top(){return frames[frames.count-1];};
+    void push(ScopeType type, Scope *record=nullptr){
+        ScopeFrame &frame = frames.newElem();
+        frame.record = record;
+        frame.start = bindings.count;
+        frame.type = type;
+    };
+    void pop(){
+        ScopeFrame frame = frames.pop();
+        while(bindings.count > frame.start){
+            Binding b = bindings.pop();
+            DynamicArray<u32> &heads = (b.isProc)?procs:vars;
+            heads[b.sym] = b.shadowed;
+        };
+    };
+    void popAll(){
+        while(frames.count) pop();
+    };
+    void bind(u32 sym, void *entity, bool isProc){
+        DynamicArray<u32> &heads = (isProc)?procs:vars;
+        Binding &b = bindings.newElem();
+        b.entity = entity;
+        b.sym = sym;
+        b.shadowed = heads[sym];
+        b.depth = frames.count;
+        b.isProc = isProc;
+        heads[sym] = bindings.count - 1;
+    };
+    VariableEntity *getVar(u32 sym){
+        u32 b = vars[sym];
+        if(b == NO_BINDING) return nullptr;
+        return (VariableEntity*)bindings[b].entity;
+    };
+    //only if the variable was defined in the current frame
+    VariableEntity *getLocalVar(u32 sym){
+        u32 b = vars[sym];
+        if(b == NO_BINDING || bindings[b].depth != frames.count) return nullptr;
+        return (VariableEntity*)bindings[b].entity;
+    };
+    ProcEntity *getProc(u32 sym){
+        u32 b = procs[sym];
+        if(b == NO_BINDING) return nullptr;
+        return (ProcEntity*)bindings[b].entity;
+    };
+    void addVar(u32 sym, VariableEntity *entity){
+        bind(sym, entity, false);
+        Scope *record = top().record;
+        if(record) record->addVar(sym, entity);
+    };
+    void addProc(u32 sym, ProcEntity *entity){
+        bind(sym, entity, true);
+        Scope *record = top().record;
+        if(record) record->addProc(sym, entity);
+    };
+    //brings the names of a checked file into the current frame
+    void import(Scope &scope){
+        if(scope.vars.len){
+            for(u32 x=0; x<scope.var.len; x++){
+                if(scope.var.isFull(x)) bind(scope.var.keys[x], scope.vars[scope.var.values[x]], false);
+            };
+        };
+        if(scope.procs.len){
+            for(u32 x=0; x<scope.proc.len; x++){
+                if(scope.proc.isFull(x)) bind(scope.proc.keys[x], scope.procs[scope.proc.values[x]], true);
+            };
+        };
+    };
+};
+static SymbolTable symbols;
+
+VariableEntity *getVariableEntity(ASTBase *node){
+    u32 sym;
     switch(node->type){
         case ASTType::VARIABLE:{
             ASTVariable *var = (ASTVariable*)node;
-            name = var->name;
+            sym = var->sym;
         }break;
         case ASTType::MODIFIER:{
             ASTModifier *mod = (ASTModifier*)node;
-            name = mod->name;
+            sym = mod->sym;
         }break;
         default: return nullptr;
     }
-    for(u32 x=scopes.count; x!=0;){
-        x -= 1;
-        Scope *scope = scopes[x];
-        u32 off;
-        if(!scope->var.getValue(name, &off)) continue;
-        return scope->vars[off];
-    };
-    return nullptr;
+    return symbols.getVar(sym);
 };
-StructEntity *getStructEntity(String name){
+StructEntity *getStructEntity(u32 sym){
     u32 off;
-    if(!struc.getValue(name, &off)) return nullptr;
+    if(!struc.getValue(sym, &off)) return nullptr;
     return &strucs[off];
 };
 StructEntity *getStructEntity(Type type){
@@ -84,16 +219,6 @@ StructEntity *getStructEntity(Type type){
     if(off > strucs.count) return nullptr;
     return &strucs[off];
 };
-ProcEntity *getProcEntity(String name, DynamicArray<Scope*> &scopes){
-    for(u32 x=scopes.count; x!=0;){
-        x -= 1;
-        Scope *scope = scopes[x];
-        u32 off;
-        if(!scope->proc.getValue(name, &off)) continue;
-        return scope->procs[off];
-    };
-    return nullptr;
-};
 
 bool fillTypeInfo(Lexer &lexer, ASTTypeNode *node){
     BRING_TOKENS_TO_SCOPE;
@@ -102,13 +227,12 @@ bool fillTypeInfo(Lexer &lexer, ASTTypeNode *node){
         return true;
     };
     if(tokTypes[node->tokenOff] != TokType::IDENTIFIER){
-        lexer.emitErr(tokOffs[node->tokenOff].off, "Expected a type or a structure name");
+        lexer.emitErr(tokOffs[node->tokenOff], "Expected a type or a structure name");
         return false;
     };
-    String name = makeStringFromTokOff(node->tokenOff, lexer);
     u32 off;
-    if(!struc.getValue(name, &off)){
-        lexer.emitErr(tokOffs[node->tokenOff].off, "Structure not defined");
+    if(!struc.getValue(getSymbol(node->tokenOff, lexer), &off)){
+        lexer.emitErr(tokOffs[node->tokenOff], "Structure not defined");
         return false;
     };
     node->zType = (Type)(off + (u32)Type::COUNT + 1);
@@ -123,22 +247,22 @@ Type checkModifierChain(Lexer &lexer, ASTBase *root, VariableEntity *entity){
         switch(root->type){
             case ASTType::MODIFIER:{
                 ASTModifier *mod = (ASTModifier*)root;
-                u32 off;
-                if(!structBodyScope->var.getValue(mod->name, &off)){
-                    lexer.emitErr(tokOffs[mod->tokenOff].off, "%.*s does not belong to the defined structure", mod->name.len, mod->name.mem);
+                VariableEntity *member = structBodyScope->getVar(mod->sym);
+                if(member == nullptr){
+                    lexer.emitErr(tokOffs[mod->tokenOff], "%.*s does not belong to the defined structure", mod->name.len, mod->name.mem);
                     return Type::INVALID;
                 }
-                return checkModifierChain(lexer, mod->child, structBodyScope->vars[off]);
+                return checkModifierChain(lexer, mod->child, member);
             }break;
             //TODO: array_at
             case ASTType::VARIABLE:{
                 ASTVariable *var = (ASTVariable*)root;
-                u32 off;
-                if(!structBodyScope->var.getValue(var->name, &off)){
-                    lexer.emitErr(tokOffs[var->tokenOff].off, "%.*s does not belong to the defined structure", var->name.len, var->name.mem);
+                VariableEntity *member = structBodyScope->getVar(var->sym);
+                if(member == nullptr){
+                    lexer.emitErr(tokOffs[var->tokenOff], "%.*s does not belong to the defined structure", var->name.len, var->name.mem);
                     return Type::INVALID;
                 };
-                return structBodyScope->vars[off]->type;
+                return member->type;
             }break;
         };
     };
@@ -162,7 +286,7 @@ u64 getSize(Lexer &lexer, Type type, u32 tokenOff){
         default:{
             StructEntity *structEntity = getStructEntity(type);
             if(structEntity == nullptr){
-                lexer.emitErr(lexer.tokenOffsets[tokenOff].off, "Structure not defined");
+                lexer.emitErr(lexer.tokenOffsets[tokenOff], "Structure not defined");
                 return 0;
             };
             return structEntity->size;
@@ -172,7 +296,7 @@ u64 getSize(Lexer &lexer, Type type, u32 tokenOff){
 
 static HashmapStr stringToId;
 
-Type checkTree(Lexer &lexer, ASTBase *node, DynamicArray<Scope*> &scopes, u32 &pointerDepth){
+Type checkTree(Lexer &lexer, ASTBase *node, u32 &pointerDepth){
     BRING_TOKENS_TO_SCOPE;
     pointerDepth = 0;
     ASTType unOpType = ASTType::INVALID;
@@ -197,10 +321,10 @@ Type checkTree(Lexer &lexer, ASTBase *node, DynamicArray<Scope*> &scopes, u32 &p
             type = Type::COMP_STRING;
         }break;
         case ASTType::VARIABLE:{
-            VariableEntity *entity = getVariableEntity(node, scopes);
+            VariableEntity *entity = getVariableEntity(node);
             if(entity == nullptr){
                 ASTVariable *var = (ASTVariable*)node;
-                lexer.emitErr(tokOffs[var->tokenOff].off, "Variable not defined");
+                lexer.emitErr(tokOffs[var->tokenOff], "Variable not defined");
                 return Type::INVALID;
             };
             pointerDepth = (pointerDepth>entity->pointerDepth)?pointerDepth:entity->pointerDepth;
@@ -208,25 +332,31 @@ Type checkTree(Lexer &lexer, ASTBase *node, DynamicArray<Scope*> &scopes, u32 &p
         }break;
         case ASTType::MODIFIER:{
             ASTModifier *mod = (ASTModifier*)node;
-            VariableEntity *entity = getVariableEntity(node, scopes);
+            VariableEntity *entity = getVariableEntity(node);
             if(entity == nullptr){
-                lexer.emitErr(tokOffs[mod->tokenOff].off, "Variable not defined");
+                lexer.emitErr(tokOffs[mod->tokenOff], "Variable not defined");
                 return Type::INVALID;
             };
             type = checkModifierChain(lexer, mod->child, entity);
         }break;
+        case ASTType::PROC_CALL:{
+            //NOTE: calls are parsed, but neither checked nor lowered yet
+            ASTProcCall *pcall = (ASTProcCall*)node;
+            lexer.emitErr(tokOffs[pcall->tokenOff], "Procedure calls are not supported yet");
+            return Type::INVALID;
+        }break;
         default:{
             if(node->type > ASTType::B_START && node->type < ASTType::B_END){
                 ASTBinOp *binOp = (ASTBinOp*)node;
                 u32 lhsUsingPointer, rhsUsingPointer;
-                Type lhsType = checkTree(lexer, binOp->lhs, scopes, lhsUsingPointer);
-                Type rhsType = checkTree(lexer, binOp->rhs, scopes, rhsUsingPointer);
+                Type lhsType = checkTree(lexer, binOp->lhs, lhsUsingPointer);
+                Type rhsType = checkTree(lexer, binOp->rhs, rhsUsingPointer);
                 if(lhsUsingPointer && rhsUsingPointer){
-                    lexer.emitErr(tokOffs[binOp->tokenOff].off, "Cannot perform binary operation with 2 pointers");
+                    lexer.emitErr(tokOffs[binOp->tokenOff], "Cannot perform binary operation with 2 pointers");
                     return Type::INVALID;
                 };
                 if(lhsType > Type::COUNT || rhsType > Type::COUNT){
-                    lexer.emitErr(tokOffs[binOp->tokenOff].off, "Cannot perform binary operation with structures");
+                    lexer.emitErr(tokOffs[binOp->tokenOff], "Cannot perform binary operation with structures");
                     return Type::INVALID;
                 };
                 type = (lhsType < rhsType)?lhsType:rhsType;
@@ -241,14 +371,14 @@ Type checkTree(Lexer &lexer, ASTBase *node, DynamicArray<Scope*> &scopes, u32 &p
                 case ASTType::BOOL:
                 case ASTType::INTEGER:
                 case ASTType::DECIMAL:
-                    lexer.emitErr(tokOffs[unOpTokenOff+1].off, "Cannot '&' on this");
+                    lexer.emitErr(tokOffs[unOpTokenOff+1], "Cannot '&' on this");
                     return Type::INVALID;
             };
         }break;
         case ASTType::U_NOT:{
             switch(type){
                 case Type::CHAR:
-                    lexer.emitErr(tokOffs[unOpTokenOff+1].off, "Cannot '!' on this");
+                    lexer.emitErr(tokOffs[unOpTokenOff+1], "Cannot '!' on this");
                     return Type::INVALID;
             };
         }break;
@@ -256,14 +386,15 @@ Type checkTree(Lexer &lexer, ASTBase *node, DynamicArray<Scope*> &scopes, u32 &p
             switch(type){
                 case Type::CHAR:
                 case Type::BOOL:
-                    lexer.emitErr(tokOffs[unOpTokenOff+1].off, "Cannot '-' on this");
+                    lexer.emitErr(tokOffs[unOpTokenOff+1], "Cannot '-' on this");
                     return Type::INVALID;
             };
         }break;
     };
     return type;
 };
-u64 checkDecl(Lexer &lexer, ASTAssDecl *assdecl, DynamicArray<Scope*> &scopes){
+//NOTE: procedure inputs may shadow names from outside the procedure
+u64 checkDecl(Lexer &lexer, ASTAssDecl *assdecl, bool isInput=false){
     BRING_TOKENS_TO_SCOPE;
     u32 typePointerDepth;
     Type typeType = Type::INVALID;
@@ -275,15 +406,15 @@ u64 checkDecl(Lexer &lexer, ASTAssDecl *assdecl, DynamicArray<Scope*> &scopes){
     };
     if(assdecl->rhs){
         u32 treePointerDepth;
-        Type treeType = checkTree(lexer, assdecl->rhs, scopes, treePointerDepth);
+        Type treeType = checkTree(lexer, assdecl->rhs, treePointerDepth);
         if(treeType == Type::INVALID) return 0;
         if(typeType != Type::INVALID){
             if(treePointerDepth != typePointerDepth){
-                lexer.emitErr(tokOffs[assdecl->tokenOff].off, "Expression tree pointer depth is not equal to type pointer depth");
+                lexer.emitErr(tokOffs[assdecl->tokenOff], "Expression tree pointer depth is not equal to type pointer depth");
                 return 0;
             };
             if(treeType < typeType){
-                lexer.emitErr(tokOffs[assdecl->tokenOff].off, "Explicit cast required");
+                lexer.emitErr(tokOffs[assdecl->tokenOff], "Explicit cast required");
                 return 0;
             };
         }else{
@@ -292,10 +423,12 @@ u64 checkDecl(Lexer &lexer, ASTAssDecl *assdecl, DynamicArray<Scope*> &scopes){
         };
     };
     u64 size = getSize(lexer, typeType, assdecl->tokenOff);
-    Scope *scope = scopes[scopes.count-1];
     for(u32 x=0; x<assdecl->lhsCount; x++){
         ASTBase *lhsNode = assdecl->lhs[x];
-        if(getVariableEntity(lhsNode, scopes)){
+        VariableEntity *defined;
+        if(isInput && lhsNode->type == ASTType::VARIABLE) defined = symbols.getLocalVar(((ASTVariable*)lhsNode)->sym);
+        else defined = getVariableEntity(lhsNode);
+        if(defined){
             u32 off;
             switch(lhsNode->type){
                 case ASTType::VARIABLE:{
@@ -308,27 +441,25 @@ u64 checkDecl(Lexer &lexer, ASTAssDecl *assdecl, DynamicArray<Scope*> &scopes){
                 }break;
                 default: UNREACHABLE;
             }
-            lexer.emitErr(tokOffs[off].off, "Redefinition");
+            lexer.emitErr(tokOffs[off], "Redefinition");
             return 0;
         };
-        String name;
-        VariableEntity *entity = (VariableEntity*)mem::alloc(sizeof(VariableEntity));
-        scope->vars.push(entity);
+        u32 sym;
+        VariableEntity *entity = varEntityPool.newElem();
         switch(lhsNode->type){
             case ASTType::VARIABLE:{
                 ASTVariable *var = (ASTVariable*)lhsNode;
-                name = var->name;
+                sym = var->sym;
                 var->entity = entity;
             }break;
             case ASTType::MODIFIER:{
                 ASTModifier *mod = (ASTModifier*)lhsNode;
-                name = mod->name;
+                sym = mod->sym;
                 mod->entity = entity;
             }break;
             default: return 0;
         };
-        u32 id = scope->vars.count - 1;
-        scope->var.insertValue(name, id);
+        symbols.addVar(sym, entity);
         entity->pointerDepth = typePointerDepth;
         entity->type = typeType;
         if(typePointerDepth > 0) entity->size = 64;
@@ -336,173 +467,153 @@ u64 checkDecl(Lexer &lexer, ASTAssDecl *assdecl, DynamicArray<Scope*> &scopes){
     };
     return size;
 };
-bool checkASTNode(Lexer &lexer, ASTBase *node, DynamicArray<Scope*> &scopes){
+bool checkASTNode(Lexer &lexer, ASTBase *node){
     BRING_TOKENS_TO_SCOPE;
-    Scope *scope = scopes[scopes.count-1];
     switch(node->type){
         case ASTType::FOR:{
             ASTFor *For = (ASTFor*)node;
-            Scope *body = &scopeAllocMem[scopeOff++];
-            body->init(ScopeType::BLOCK);
+            VariableEntity *iterator = nullptr;
             if(For->initializer != nullptr){
                 //c-for
-                bool found = false;
-                for(u32 x=scopes.count; x!=0;){
-                    x -= 1;
-                    Scope *scope = scopes[x];
-                    u32 off;
-                    if(!scope->var.getValue(For->iter, &off)) continue;
-                    found = true;
-                    break;
-                };
-                if(found){
-                    lexer.emitErr(tokOffs[For->tokenOff].off, "Iterator defined before");
+                if(symbols.getVar(For->iterSym)){
+                    lexer.emitErr(tokOffs[For->tokenOff], "Iterator defined before");
                     return false;
                 };
                 u32 initializerPointerDepth, endPointerDepth;
-                Type initializerType = checkTree(lexer, For->initializer, scopes, initializerPointerDepth);
-                Type endType = checkTree(lexer, For->end, scopes, endPointerDepth);
+                Type initializerType = checkTree(lexer, For->initializer, initializerPointerDepth);
+                Type endType = checkTree(lexer, For->end, endPointerDepth);
                 if(initializerType == Type::INVALID) return false;
                 if(endType == Type::INVALID) return false;
                 if(initializerType != endType){
-                    lexer.emitErr(tokOffs[For->tokenOff].off, "Initializer type not equal to end type");
+                    lexer.emitErr(tokOffs[For->tokenOff], "Initializer type not equal to end type");
                     return false;
                 };
                 if(initializerPointerDepth != endPointerDepth){
-                    lexer.emitErr(tokOffs[For->tokenOff].off, "Initializer pointer depth not equal to end pointer depth");
+                    lexer.emitErr(tokOffs[For->tokenOff], "Initializer pointer depth not equal to end pointer depth");
                     return false;
                 };
                 if(For->step){
                     u32 stepPointerDepth;
-                    Type stepType = checkTree(lexer, For->step, scopes, stepPointerDepth);
+                    Type stepType = checkTree(lexer, For->step, stepPointerDepth);
                     if(stepType == Type::INVALID) return false;
                     if(!isNumber(stepType)){
-                        lexer.emitErr(tokOffs[For->tokenOff].off, "Step type should be an integer");
+                        lexer.emitErr(tokOffs[For->tokenOff], "Step type should be an integer");
                         return false;
                     };
                     if(stepPointerDepth > 0){
-                        lexer.emitErr(tokOffs[For->tokenOff].off, "Step expression tree cannot contain pointers");
+                        lexer.emitErr(tokOffs[For->tokenOff], "Step expression tree cannot contain pointers");
                         return false;
                     };
                 };
                 if(For->type){
                     if(!fillTypeInfo(lexer, For->type)) return false;
                 };
-                body->var.insertValue(For->iter, body->vars.count);
-                VariableEntity *entity = (VariableEntity*)mem::alloc(sizeof(VariableEntity));
+                VariableEntity *entity = varEntityPool.newElem();
+                iterator = entity;
                 entity->type = initializerType;
                 if(initializerPointerDepth > 0) entity->size = 64;
                 else if(initializerType > Type::COUNT){
-                    lexer.emitErr(tokOffs[For->tokenOff].off, "Iterator has to be of type integer or a pointer");
+                    lexer.emitErr(tokOffs[For->tokenOff], "Iterator has to be of type integer or a pointer");
                     return false;
                 }else entity->size = getSize(lexer, initializerType, For->tokenOff);
                 entity->pointerDepth = initializerPointerDepth;
-                body->vars.push(entity);
             }else{
                 //c-while
-                if(!checkASTNode(lexer, For->expr, scopes)) return false;
+                if(!checkASTNode(lexer, For->expr)) return false;
             };
-            scopes.push(body);
+            symbols.push(ScopeType::BLOCK);
+            if(iterator) symbols.addVar(For->iterSym, iterator);
             for(u32 x=0; x<For->bodyCount; x++){
-                if(!checkASTNode(lexer, For->body[x], scopes)) return false;
+                if(!checkASTNode(lexer, For->body[x])) return false;
             };
-            scopes.pop();
+            symbols.pop();
         }break;
         case ASTType::PROC_DEF:{
             ASTProcDefDecl *proc = (ASTProcDefDecl*)node;
-            if(scope->type != ScopeType::GLOBAL){
-                lexer.emitErr(tokOffs[proc->tokenOff].off, "Procedure can only be defined in the global scope");
+            if(symbols.top().type != ScopeType::GLOBAL){
+                lexer.emitErr(tokOffs[proc->tokenOff], "Procedure can only be defined in the global scope");
                 return false;
             };
-            if(getProcEntity(proc->name, scopes)){
-                lexer.emitErr(tokOffs[proc->tokenOff].off, "Procedure with this name already exists");
+            if(symbols.getProc(proc->sym)){
+                lexer.emitErr(tokOffs[proc->tokenOff], "Procedure with this name already exists");
                 return false;
             };
-            scope->proc.insertValue(proc->name, scope->procs.count);
-            ProcEntity *entity = (ProcEntity*)mem::alloc(sizeof(ProcEntity));
-            scope->procs.push(entity);
-            Scope *body = &scopeAllocMem[scopeOff++];
-            body->init(ScopeType::BLOCK);
+            ProcEntity *entity = procEntityPool.newElem();
+            symbols.addProc(proc->sym, entity);
             entity->inputs = proc->inputs;
             entity->inputCount = proc->inputCount;
             entity->outputs = proc->outputs;
             entity->outputCount = proc->outputCount;
-            scopes.push(body);
-            DynamicArray<Scope*> procInputScope;
-            procInputScope.init(1);
-            procInputScope.push(body);
-            DEFER({
-                procInputScope.uninit();
-                scopes.pop();
-            });
+            symbols.push(ScopeType::PROC);
+            DEFER(symbols.pop());
             for(u32 x=0; x<proc->inputCount; x++){
                 if(proc->inputs[x]->type != ASTType::DECLERATION){
-                    lexer.emitErr(tokOffs[proc->tokenOff].off, "One of the input is not a decleration");
+                    lexer.emitErr(tokOffs[proc->tokenOff], "One of the input is not a decleration");
                     return false;
                 };
                 ASTAssDecl *input = proc->inputs[x];
                 if(input->rhs){
-                    lexer.emitErr(tokOffs[proc->tokenOff].off, "Zeus does not support default argument");
+                    lexer.emitErr(tokOffs[proc->tokenOff], "Zeus does not support default argument");
                     return false;
                 };
-                if(checkDecl(lexer, input, procInputScope) == 0) return false;
+                if(checkDecl(lexer, input, true) == 0) return false;
             };
             for(u32 x=0; x<proc->outputCount; x++){
                 if(!fillTypeInfo(lexer, proc->outputs[x])) return false;
             };
             for(u32 x=0; x<proc->bodyCount; x++){
-                if(!checkASTNode(lexer, proc->body[x], scopes)) return false;
+                if(!checkASTNode(lexer, proc->body[x])) return false;
             };
         }break;
         case ASTType::STRUCT:{
             ASTStruct *Struct = (ASTStruct*)node;
-            if(getStructEntity(Struct->name)){
-                lexer.emitErr(tokOffs[Struct->tokenOff].off, "Structure already defined");
+            if(getStructEntity(Struct->sym)){
+                lexer.emitErr(tokOffs[Struct->tokenOff], "Structure already defined");
                 return false;
             };
             u32 id = strucs.count;
-            struc.insertValue(Struct->name, id);
+            struc.insertValue(Struct->sym, id);
             StructEntity *entity = &strucs.newElem();
-            Scope *body = &structScopeAllocMem[structScopeOff++];
-            body->init(ScopeType::BLOCK);
+            Scope *body = structScopePool.newElem();
+            body->init(ScopeType::BLOCK, &checkerArena);
             entity->body = body;
             u64 size = 0;
-            scopes.push(body);
+            symbols.push(ScopeType::BLOCK, body);
             for(u32 x=0; x<Struct->bodyCount; x++){
                 ASTAssDecl *node = (ASTAssDecl*)Struct->body[x];
                 if(node->type != ASTType::DECLERATION){
-                    lexer.emitErr(tokOffs[Struct->tokenOff].off, "Body should contain only declerations");
+                    lexer.emitErr(tokOffs[Struct->tokenOff], "Body should contain only declerations");
                     return false;
                 };
                 if(node->rhs){
-                    lexer.emitErr(tokOffs[Struct->tokenOff].off, "Body should not contain decleration with RHS(expression tree)");
+                    lexer.emitErr(tokOffs[Struct->tokenOff], "Body should not contain decleration with RHS(expression tree)");
                     return false;
                 }
-                u64 temp = checkDecl(lexer, node, scopes);
+                u64 temp = checkDecl(lexer, node);
                 if(temp == 0) return false;
                 size += temp;
             };
             entity->size = size;
-            scopes.pop();
+            symbols.pop();
         }break;
         case ASTType::DECLERATION:{
-            if(checkDecl(lexer, (ASTAssDecl*)node, scopes) == 0) return false;
+            if(checkDecl(lexer, (ASTAssDecl*)node) == 0) return false;
         }break;
         case ASTType::ASSIGNMENT:{
             ASTAssDecl *assdecl = (ASTAssDecl*)node;
             if(assdecl->lhsCount > 1 && assdecl->rhs->type != ASTType::PROC_CALL){
-                lexer.emitErr(tokOffs[assdecl->tokenOff].off, "If LHS has many elements, then RHS should be a procedure call returning same number of elements");
+                lexer.emitErr(tokOffs[assdecl->tokenOff], "If LHS has many elements, then RHS should be a procedure call returning same number of elements");
                 return false;
             };
             for(u32 x=0; x<assdecl->lhsCount; x++){
                 ASTBase *node = assdecl->lhs[x];
-                VariableEntity *entity = getVariableEntity(node, scopes);
+                VariableEntity *entity = getVariableEntity(node);
                 if(entity == nullptr){
                     if(node->type == ASTType::VARIABLE || node->type == ASTType::MODIFIER){
-                            lexer.emitErr(tokOffs[assdecl->tokenOff].off, "Variable not defined in LHS(%d)", x);
+                            lexer.emitErr(tokOffs[assdecl->tokenOff], "Variable not defined in LHS(%d)", x);
                             return false;
                     };
-                    lexer.emitErr(tokOffs[assdecl->tokenOff].off, "Only variable or modifiers allowed in LHS");
+                    lexer.emitErr(tokOffs[assdecl->tokenOff], "Only variable or modifiers allowed in LHS");
                     return false;
                 };
                 if(node->type == ASTType::MODIFIER){
@@ -512,70 +623,70 @@ bool checkASTNode(Lexer &lexer, ASTBase *node, DynamicArray<Scope*> &scopes){
             };
             if(assdecl->lhsCount > 1 && assdecl->rhs->type == ASTType::PROC_CALL){
                 ASTProcCall *procCall = (ASTProcCall*)assdecl->rhs;
-                ProcEntity *entity = getProcEntity(procCall->name, scopes);
+                ProcEntity *entity = symbols.getProc(procCall->sym);
                 if(entity == nullptr){
-                    lexer.emitErr(tokOffs[procCall->tokenOff].off, "Procedure not defined");
+                    lexer.emitErr(tokOffs[procCall->tokenOff], "Procedure not defined");
                     return false;
                 };
                 if(entity->outputCount > assdecl->lhsCount){
-                    lexer.emitErr(tokOffs[assdecl->tokenOff].off, "RHS returns more than what LHS can catch");
+                    lexer.emitErr(tokOffs[assdecl->tokenOff], "RHS returns more than what LHS can catch");
                     return false;
                 };
                 if(entity->outputCount < assdecl->lhsCount){
-                    lexer.emitErr(tokOffs[assdecl->tokenOff].off, "RHS returns less than what LHS can catch");
+                    lexer.emitErr(tokOffs[assdecl->tokenOff], "RHS returns less than what LHS can catch");
                     return false;
                 };
                 if(entity->inputCount != procCall->argCount){
-                    lexer.emitErr(tokOffs[procCall->tokenOff].off, "Procedure defined with %d input%sbut you provided %d input%s",
+                    lexer.emitErr(tokOffs[procCall->tokenOff], "Procedure defined with %d input%sbut you provided %d input%s",
                                   entity->inputCount, entity->inputCount>1?"s ":" ", procCall->argCount, procCall->argCount>1?"s ":" ");
                 };
                 for(u32 x=0; x<entity->inputCount; x++){
-                    if(!checkASTNode(lexer, procCall->args[x], scopes)) return false;
+                    if(!checkASTNode(lexer, procCall->args[x])) return false;
                 };
             }else{
                 u32 treePointerDepth;
-                Type treeType = checkTree(lexer, assdecl->rhs, scopes, treePointerDepth);
+                Type treeType = checkTree(lexer, assdecl->rhs, treePointerDepth);
                 if(treeType == Type::INVALID) return false;
             }
         }break;
         case ASTType::IF:{
             ASTIf *If = (ASTIf*)node;
             u32 treePointerDepth;
-            Type treeType = checkTree(lexer, If->expr, scopes, treePointerDepth);
+            Type treeType = checkTree(lexer, If->expr, treePointerDepth);
             if(treeType == Type::INVALID) return false;
             if(treeType > Type::COUNT && treePointerDepth == 0){
-                lexer.emitErr(tokOffs[If->exprTokenOff].off, "Invalid expression");
+                lexer.emitErr(tokOffs[If->exprTokenOff], "Invalid expression");
                 return false;
             };
-            Scope *bodyScope = &scopeAllocMem[scopeOff++];
-            bodyScope->init(ScopeType::BLOCK);
-            scopes.push(bodyScope);
+            symbols.push(ScopeType::BLOCK);
             for(u32 x=0; x<If->ifBodyCount; x++){
-                if(!checkASTNode(lexer, If->ifBody[x], scopes)) return false;
+                if(!checkASTNode(lexer, If->ifBody[x])) return false;
             };
-            scopes.pop();
+            symbols.pop();
             if(If->elseBodyCount > 0){
-                Scope *elseBodyScope = &scopeAllocMem[scopeOff++];
-                elseBodyScope->init(ScopeType::BLOCK);
-                scopes.push(elseBodyScope);
+                symbols.push(ScopeType::BLOCK);
                 for(u32 x=0; x<If->elseBodyCount; x++){
-                    if(!checkASTNode(lexer, If->elseBody[x], scopes)) return false;
+                    if(!checkASTNode(lexer, If->elseBody[x])) return false;
                 };
-                scopes.pop();
+                symbols.pop();
             };
         }break;
+        case ASTType::PROC_CALL:{
+            u32 pointerDepth;
+            checkTree(lexer, node, pointerDepth);
+            return false;
+        }break;
     };
     return true;
 };
 bool checkASTFile(Lexer &lexer, ASTFile &file, Scope &scope, DynamicArray<ASTBase*> &globals){
-    scope.init(ScopeType::GLOBAL);
-    DynamicArray<Scope*> scopes;
-    scopes.init();
-    DEFER(scopes.uninit());
-    for(u32 x=0; x<file.dependencies.count; x++) scopes.push(&globalScopes[file.dependencies[x]]);
-    scopes.push(&scope);
+    scope.init(ScopeType::GLOBAL, &checkerArena);
+    DEFER(symbols.popAll());
+    symbols.push(ScopeType::GLOBAL);
+    for(u32 x=0; x<file.dependencies.count; x++) symbols.import(globalScopes[file.dependencies[x]]);
+    symbols.push(ScopeType::GLOBAL, &scope);
     for(u32 x=0; x<file.nodes.count; x++){
-        if(!checkASTNode(lexer, file.nodes[x], scopes)) return false;
+        if(!checkASTNode(lexer, file.nodes[x])) return false;
     };
     const u32 curOff = &scope - globalScopes;
     for(u32 x=0; x<file.nodes.count;){
@@ -587,7 +698,7 @@ bool checkASTFile(Lexer &lexer, ASTFile &file, Scope &scope, DynamicArray<ASTBas
             case ASTType::DECLERATION:{
                 ASTAssDecl *assdecl = (ASTAssDecl*)node;
                 if(assdecl->lhsCount > 1){
-                    lexer.emitErr(lexer.tokenOffsets[assdecl->tokenOff].off, "In the global scope, lhs count has to be 1");
+                    lexer.emitErr(lexer.tokenOffsets[assdecl->tokenOff], "In the global scope, lhs count has to be 1");
                     return false;
                 };
                 switch(assdecl->rhs->type){
@@ -596,15 +707,14 @@ bool checkASTFile(Lexer &lexer, ASTFile &file, Scope &scope, DynamicArray<ASTBas
                     case ASTType::CHARACTER:
                     case ASTType::STRING: break;
                     default:{
-                        lexer.emitErr(lexer.tokenOffsets[assdecl->tokenOff].off, "In the global scope, rhs has to be an integer, decimal, character or a string. No expressions allowed");
+                        lexer.emitErr(lexer.tokenOffsets[assdecl->tokenOff], "In the global scope, rhs has to be an integer, decimal, character or a string. No expressions allowed");
                         return false;
                     }break;
                 };
                 for(u32 y=curOff+1; y<linearDepEntities.count; y++){
-                    u32 off;
                     ASTVariable *var = (ASTVariable*)assdecl->lhs[0];
-                    if(globalScopes[y].var.getValue(var->name, &off)){
-                        lexer.emitErr(lexer.tokenOffsets[assdecl->tokenOff].off, "Variable already declared at global scope in %s", linearDepEntities[y].lexer.fileName);
+                    if(globalScopes[y].getVar(var->sym)){
+                        lexer.emitErr(lexer.tokenOffsets[assdecl->tokenOff], "Variable already declared at global scope in %s", linearDepEntities[y].lexer.fileName);
                         return false;
                     };
                 };
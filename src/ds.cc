@@ -66,9 +66,21 @@ struct String {
 	return mem[index];
     };
 };
-bool cmpString(String str1, String str2) {
+#if(SIMD)
+//a 16 byte load from ptr stays in its page, so reading past the string can not fault
+#define SAFE_LOAD16(ptr) ((((u64)(ptr)) & 4095) <= 4096 - 16)
+#endif
+inline bool cmpString(String str1, String str2) {
     if (str1.len != str2.len) { return false; };
-    //TODO: SIMD??
+#if(SIMD)
+    //identifiers are short: one masked compare instead of a memcmp call
+    if(str1.len <= 16 && SAFE_LOAD16(str1.mem) && SAFE_LOAD16(str2.mem)){
+	__m128i a = _mm_loadu_si128((const __m128i*)str1.mem);
+	__m128i b = _mm_loadu_si128((const __m128i*)str2.mem);
+	u32 diff = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) ^ 0xFFFF;
+	return (diff & ((1u << str1.len) - 1)) == 0;
+    };
+#endif
     return memcmp(str1.mem, str2.mem, str1.len) == 0;
 };
 bool cmpString(String str1, char *str2){
@@ -81,17 +93,23 @@ bool cmpString(String str1, char *str2){
 template<typename T>
 struct DynamicArray {
     T *mem;
+    mem::Arena *arena;    //nullptr when living in the general pool
     u32 count;
     u32 len;
 
     void zero(){
 	count = 0;
 	len = 0;
+	arena = nullptr;
     }
     void realloc(u32 newCap) {
-	void *newMem = mem::alloc(sizeof(T) * newCap);
-	memcpy(newMem, mem, sizeof(T) * len);
-	mem::free(mem);
+	if(mem::tryExtend(mem, sizeof(T) * len, sizeof(T) * newCap, arena)){
+	    len = newCap;
+	    return;
+	};
+	void *newMem = mem::alloc(sizeof(T) * newCap, arena);
+	memcpy(newMem, mem, sizeof(T) * count);
+	mem::free(mem, arena);
 	mem = (T*)newMem;
 	len = newCap;
     };
@@ -104,12 +122,13 @@ struct DynamicArray {
 	return mem[index];
     };
     T &operator[](u32 index) { return getElement(index); };
-    void init(u32 startCount = 5) {
+    void init(u32 startCount = 5, mem::Arena *a = nullptr MEM_SITE_PARAMS) {
 	count = 0;
 	len = startCount;
-	mem = (T*)mem::alloc(sizeof(T) * startCount);
+	arena = a;
+	mem = (T*)mem::alloc(sizeof(T) * startCount, arena MEM_SITE_ARGS);
     };
-    void uninit() { mem::free(mem); };
+    void uninit() { mem::free(mem, arena); };
     void push(const T &t) {
 	if (count == len) { realloc(len + len / 2 + 1); };
 	mem[count] = t;
@@ -136,157 +155,684 @@ struct DynamicArray {
 #endif
 };
 
+//array with room for N elements inside itself. Goes to the heap only past N.
+//NOTE: points into itself, so it must not be copied
+template<typename T, u32 N>
+struct SmallArray {
+    T *mem;
+    u32 count;
+    u32 len;
+    T inlineMem[N];
+
+    void init(){
+	mem = inlineMem;
+	count = 0;
+	len = N;
+    };
+    void uninit(){
+	if(mem != inlineMem){mem::free(mem);};
+    };
+    T &operator[](u32 index) {
+#if(DBG == true)
+	if (index >= count) {
+	    printf("\n[ERROR]: abc(small_array) failed for type %s. index = %d\n", typeid(T).name(), index);
+	};
+#endif
+	return mem[index];
+    };
+    void push(const T &t) {
+	if (count == len) {
+	    u32 newLen = len * 2;
+	    if(mem == inlineMem){
+		mem = (T*)mem::alloc(sizeof(T) * newLen);
+		memcpy(mem, inlineMem, sizeof(T) * count);
+	    }else if(!mem::tryExtend(mem, sizeof(T) * newLen)){
+		T *newMem = (T*)mem::alloc(sizeof(T) * newLen);
+		memcpy(newMem, mem, sizeof(T) * count);
+		mem::free(mem);
+		mem = newMem;
+	    };
+	    len = newLen;
+	};
+	mem[count] = t;
+	count += 1;
+    };
+};
+
+//typed pool handing out objects from slabs of slabLen. Objects never move.
+//There is no per object free; reset hands the slabs out again
+template<typename T, u32 slabLen = 64>
+struct SlabPool {
+    struct Slab{
+	Slab *next;
+	T     objs[slabLen];
+    };
+    Slab *first;
+    Slab *cur;
+    u32   used;     //objects handed out from cur
+
+    void init(){
+	first = nullptr;
+	cur = nullptr;
+	used = slabLen;
+    };
+    void uninit(){
+	Slab *slab = first;
+	while(slab){
+	    Slab *next = slab->next;
+	    mem::free(slab);
+	    slab = next;
+	};
+	init();
+    };
+    T *newElem(){
+	if(used == slabLen){
+	    Slab *next = (cur)?cur->next:first;
+	    if(next == nullptr){
+		next = (Slab*)mem::alloc(sizeof(Slab));
+		next->next = nullptr;
+		if(cur){cur->next = next;}
+		else{first = next;};
+	    };
+	    cur = next;
+	    used = 0;
+	};
+	used += 1;
+	return &cur->objs[used-1];
+    };
+    void reset(){
+	cur = nullptr;
+	used = slabLen;
+    };
+};
+
+//64x64->128 bit multiply, folded back to 64 bits
+inline u64 hashMix(u64 a, u64 b){
+#ifdef _MSC_VER
+    u64 hi;
+    u64 lo = _umul128(a, b, &hi);
+    return lo ^ hi;
+#else
+    __uint128_t r = (__uint128_t)a * b;
+    return (u64)r ^ (u64)(r >> 64);
+#endif
+};
+inline u64 load64(const u8 *p){u64 v; memcpy(&v, p, 8); return v;};
+inline u64 load32(const u8 *p){u32 v; memcpy(&v, p, 4); return v;};
+//wyhash: 16 bytes per multiply instead of FNV's 1 byte per multiply.
+//Keys up to 16 bytes(most identifiers) are read with overlapping loads and no loop
+u32 hashString(const char *mem, u32 len){
+    const u64 s0 = 0xa0761d6478bd642full;
+    const u64 s1 = 0xe7037ed1a0b428dbull;
+    const u8 *p = (const u8*)mem;
+    u64 seed = s0;
+    u64 a, b;
+    if(len <= 16){
+	if(len >= 4){
+	    u32 mid = (len >> 3) << 2;
+	    a = (load32(p) << 32) | load32(p + mid);
+	    b = (load32(p + len - 4) << 32) | load32(p + len - 4 - mid);
+	}else if(len > 0){
+	    a = ((u64)p[0] << 16) | ((u64)p[len >> 1] << 8) | p[len - 1];
+	    b = 0;
+	}else{
+	    a = 0;
+	    b = 0;
+	};
+    }else{
+	u32 x = 0;
+	for(; x + 16 < len; x += 16){seed = hashMix(load64(p + x) ^ s1, load64(p + x + 8) ^ seed);};
+	a = load64(p + len - 16);
+	b = load64(p + len - 8);
+    };
+    return (u32)hashMix(s1 ^ len, hashMix(a ^ s1, b ^ seed));
+};
+//fibonacci hashing. The high half of the product depends on every bit of the key
+inline u32 hashInt(u64 key){return (u32)((key * 0x9E3779B97F4A7C15ull) >> 32);};
+
+//a table grows once more than HMAP_MAX_LOAD percent of its slots are full
+#ifndef HMAP_MAX_LOAD
+#define HMAP_MAX_LOAD 87
+#endif
+static_assert(HMAP_MAX_LOAD > 0 && HMAP_MAX_LOAD < 100, "HMAP_MAX_LOAD has to be a percentage below 100");
+inline u32 hmapMaxCount(u32 slots){return (u32)(((u64)slots * HMAP_MAX_LOAD) / 100);};
+
+#if(HMAP_PROF)
+#define MAX_HMAP_SITES     128
+#define HMAP_PROBE_BUCKETS 16
+/*
+  Opt-in hash table statistics(build with -D HMAP_PROF=1). Tables are grouped by the
+  call site that initialized them, so every struct scope of the checker shares a line.
+  A probe is a slot looked at, or a group of HMAP_GROUP slots for HashmapStr.
+  Counters are not synchronized, so numbers are only exact for single threaded runs
+*/
+namespace hmapProf{
+    struct Site{
+	const char *kind;
+	const char *file;
+	u32 line;
+	u32 tables;
+	u32 resizes;
+	u32 maxLen;        //most slots a table of the site had
+	u64 lookups;
+	u64 hits;
+	u64 inserts;
+	u64 removes;
+	u64 probes;
+	u64 collisions;    //keys compared that were not the one looked for
+	u64 histogram[HMAP_PROBE_BUCKETS];     //lookups by probes. The last bucket takes the longer ones
+    };
+    Site sites[MAX_HMAP_SITES];
+    u32 siteCount = 0;
+
+    u16 getSite(const char *kind, const char *file, u32 line){
+	for(u32 x=0; x<siteCount; x+=1){
+	    if(sites[x].line == line && sites[x].file == file && sites[x].kind == kind){return x;};
+	};
+	if(siteCount == MAX_HMAP_SITES){return MAX_HMAP_SITES - 1;};      //full, charge to the last site
+	Site &site = sites[siteCount];
+	site.kind = kind;
+	site.file = file;
+	site.line = line;
+	return siteCount++;
+    };
+    inline void onAlloc(u16 id, u32 len){
+	if(len > sites[id].maxLen){sites[id].maxLen = len;};
+    };
+    inline void onLookup(u16 id, u32 probes, bool hit){
+	Site &site = sites[id];
+	site.lookups += 1;
+	site.hits += hit;
+	site.probes += probes;
+	site.histogram[(probes < HMAP_PROBE_BUCKETS)?probes-1:HMAP_PROBE_BUCKETS-1] += 1;
+    };
+    void dump(){
+	if(siteCount == 0){return;};
+	printf("\n[HMAP_PROF] %-22s %-10s %6s %7s %9s %10s %6s %9s %10s %10s %8s\n",
+	       "init site", "table", "tables", "resizes", "max slots", "lookups", "hit%", "avg probe", "collisions", "inserts", "removes");
+	char name[256];
+	for(u32 x=0; x<siteCount; x+=1){
+	    Site &site = sites[x];
+	    const char *file = site.file;
+	    const char *slash = strrchr(file, '/');
+	    if(slash){file = slash + 1;};
+	    snprintf(name, sizeof(name), "%s:%u", file, site.line);
+	    f64 hitRate = (site.lookups == 0)?0:100.0 * site.hits / site.lookups;
+	    f64 avgProbe = (site.lookups == 0)?0:(f64)site.probes / site.lookups;
+	    printf("  %-32s %-10s %6u %7u %9u %10llu %6.1f %9.2f %10llu %10llu %8llu\n", name, site.kind, site.tables, site.resizes,
+		   site.maxLen, site.lookups, hitRate, avgProbe, site.collisions, site.inserts, site.removes);
+	    if(site.lookups == 0){continue;};
+	    printf("    probes:");
+	    for(u32 i=0; i<HMAP_PROBE_BUCKETS; i+=1){
+		if(site.histogram[i] == 0){continue;};
+		printf(" %u%s:%llu", i+1, (i == HMAP_PROBE_BUCKETS-1)?"+":"", site.histogram[i]);
+	    };
+	    printf("\n");
+	};
+    };
+};
+#endif
+//prints the per table summary(HMAP_PROF builds)
+inline void dumpHashmapStats(){
+#if(HMAP_PROF)
+    hmapProf::dump();
+#endif
+};
+
+/*
+  Open addressing table with a control byte per slot(swiss table).
+  A full slot stores the top 7 bits of its key's hash, an empty one has the high bit set.
+  Slots are probed a group of 16 at a time, so keys are only compared when the tag matches
+*/
+#define HMAP_GROUP 16
+#define HMAP_EMPTY 0x80
 struct HashmapStr{
     String *keys;
     u32    *values;
-    bool   *status;
+    u32    *hashes;     //full hash of every key. Growing never hashes a key again
+    u8     *ctrl;       //control byte of every slot
+    mem::Arena *arena;
     u32     count;
-    u32     len;
-    
-    void init(u32 initialCapacity=10){
-	len = initialCapacity;
+    u32     len;        //power of 2 and a multiple of HMAP_GROUP
+#if(HMAP_PROF)
+    u16     profId;
+#endif
+
+    //slots needed to hold count keys without going over the load factor
+    static u32 slotsFor(u32 count){
+	u32 slots = HMAP_GROUP;
+	while(count > hmapMaxCount(slots)){slots <<= 1;};
+	return slots;
+    };
+    void alloc(u32 slots MEM_SITE_PARAMS){
+	len = slots;
+	keys = (String*)mem::alloc(sizeof(String)*len, arena MEM_SITE_ARGS);
+	values = (u32*)mem::alloc(sizeof(u32)*len, arena MEM_SITE_ARGS);
+	hashes = (u32*)mem::alloc(sizeof(u32)*len, arena MEM_SITE_ARGS);
+	ctrl = (u8*)mem::alloc(len, arena MEM_SITE_ARGS);
+	memset(ctrl, HMAP_EMPTY, len);
+#if(HMAP_PROF)
+	hmapProf::onAlloc(profId, len);
+#endif
+    };
+    void init(u32 initialCapacity=10, mem::Arena *a=nullptr MEM_SITE_PARAMS){
 	count = 0;
-	keys = (String*)mem::alloc(sizeof(String)*len);
-	values = (u32*)mem::alloc(sizeof(u32)*len);
-	status = (bool*)mem::alloc(sizeof(bool)*len);
-	memset(status, false, sizeof(bool)*len);
+	arena = a;
+#if(HMAP_PROF)
+	profId = hmapProf::getSite("HashmapStr", file, line);
+	hmapProf::sites[profId].tables += 1;
+#endif
+	alloc(slotsFor(initialCapacity) MEM_SITE_ARGS);
     };
     void uninit(){
-	mem::free(keys);
-	mem::free(values);
-	mem::free(status);
+	mem::free(keys, arena);
+	mem::free(values, arena);
+	mem::free(hashes, arena);
+	mem::free(ctrl, arena);
     };
-    u32 hashFunc(const String &key){
-	//fnv_hash_1a_32
-	u32 h = 0x811c9dc5;
-	for(u32 i=0; i<key.len; i+=1){h = (h^key.mem[i]) * 0x01000193;};
-	return h;
+    u32 hashFunc(const String &key){return hashString(key.mem, key.len);};
+    inline bool isFull(u32 slot){return (ctrl[slot] & HMAP_EMPTY) == 0;};
+    //bit i is set if slot i of the group has the tag
+    static inline u32 matchTag(const u8 *group, u8 tag){
+#if(SIMD)
+	__m128i g = _mm_loadu_si128((const __m128i*)group);
+	return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char)tag)));
+#else
+	u32 mask = 0;
+	for(u32 i=0; i<HMAP_GROUP; i+=1){mask |= (u32)(group[i] == tag) << i;};
+	return mask;
+#endif
+    };
+    static inline u32 matchEmpty(const u8 *group){
+#if(SIMD)
+	return (u32)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#else
+	u32 mask = 0;
+	for(u32 i=0; i<HMAP_GROUP; i+=1){mask |= (u32)(group[i] >> 7) << i;};
+	return mask;
+#endif
     };
     bool getValue(const String &key, u32 *value){
-	u32 startHash = hashFunc(key) % len;
-	u32 hash = startHash;
-	while(status[hash] == true){
-	    if(cmpString(key, keys[hash])){
-		*value = values[hash];
-		return true;
+	u32 hash = hashFunc(key);
+	u8 tag = (u8)(hash >> 25);
+	u32 groupMask = len/HMAP_GROUP - 1;
+	u32 group = hash & groupMask;
+#if(HMAP_PROF)
+	u32 probes = 0;
+#endif
+	//the table is never full, so there is always an empty slot to stop at
+	while(true){
+	    const u8 *g = ctrl + group*HMAP_GROUP;
+	    u32 match = matchTag(g, tag);
+#if(HMAP_PROF)
+	    probes += 1;
+#endif
+	    while(match){
+		u32 slot = group*HMAP_GROUP + ctz64(match);
+		if(hashes[slot] == hash && cmpString(key, keys[slot])){
+		    *value = values[slot];
+#if(HMAP_PROF)
+		    hmapProf::onLookup(profId, probes, true);
+#endif
+		    return true;
+		};
+#if(HMAP_PROF)
+		hmapProf::sites[profId].collisions += 1;
+#endif
+		match &= match - 1;
 	    };
-	    hash += 1;
-	    if(hash >= len){hash = 0;};
-	    if (hash == startHash){ return false; };
+	    if(matchEmpty(g)){
+#if(HMAP_PROF)
+		hmapProf::onLookup(profId, probes, false);
+#endif
+		return false;
+	    };
+	    group = (group + 1) & groupMask;
 	};
-	return false;
     };
-    bool _insert_value(String &key, u32 value, u32 length, bool *statusArr, String *keysArr, u32 *valuesArr){
-	u32 hash = hashFunc(key) % length;
-	while(statusArr[hash]){
-	    hash += 1;
-	    if(hash >= length){hash = 0;};
+    void _insert_value(const String &key, u32 value, u32 hash){
+	u32 groupMask = len/HMAP_GROUP - 1;
+	u32 group = hash & groupMask;
+	u32 empty;
+	while((empty = matchEmpty(ctrl + group*HMAP_GROUP)) == 0){group = (group + 1) & groupMask;};
+	u32 slot = group*HMAP_GROUP + ctz64(empty);
+	ctrl[slot] = (u8)(hash >> 25);
+	keys[slot] = key;
+	values[slot] = value;
+	hashes[slot] = hash;
+    };
+    void grow(){
+	String *oldKeys = keys;
+	u32 *oldValues = values;
+	u32 *oldHashes = hashes;
+	u8 *oldCtrl = ctrl;
+	u32 oldLen = len;
+#if(HMAP_PROF)
+	hmapProf::sites[profId].resizes += 1;
+#endif
+	alloc(len << 1);
+	for(u32 x=0; x<oldLen; x+=1){
+	    if(oldCtrl[x] & HMAP_EMPTY){continue;};
+	    _insert_value(oldKeys[x], oldValues[x], oldHashes[x]);
 	};
-	statusArr[hash] = true;
-	keysArr[hash] = key;
-	valuesArr[hash] = value;
-	return true;
+	mem::free(oldKeys, arena);
+	mem::free(oldValues, arena);
+	mem::free(oldHashes, arena);
+	mem::free(oldCtrl, arena);
     };
     bool insertValue(String key, u32 value){
-	if(count == len){
-	    u32 newLen = len + (u32)(len/2) + 10;
-	    String *newKeys = (String*)mem::alloc(sizeof(String)*newLen);
-	    u32 *newValues = (u32*)mem::alloc(sizeof(u32)*newLen);
-	    bool *newStatus = (bool*)mem::alloc(sizeof(bool)*newLen);
-	    memset(newStatus, false, sizeof(bool)*newLen);
-	    for(u32 x=0; x<len; x+=1){
-		String tempKey = keys[x];
-		u32 val;
-		getValue(tempKey, &val);
-		_insert_value(tempKey, val, newLen, newStatus, newKeys, newValues);
+	if(count + 1 > hmapMaxCount(len)){grow();};
+	_insert_value(key, value, hashFunc(key));
+	count += 1;
+#if(HMAP_PROF)
+	hmapProf::sites[profId].inserts += 1;
+#endif
+	return true;
+    };
+};
+//an insert whose probe gets longer than this grows the table
+#ifndef HMAP_MAX_PROBE
+#define HMAP_MAX_PROBE 255
+#endif
+static_assert(HMAP_MAX_PROBE > 0 && HMAP_MAX_PROBE < 256, "probe lengths are stored in a byte");
+/*
+  Robin Hood open addressing for integer and pointer keys(up to 64 bits).
+  An insert takes the slot of any key that sits closer to its home slot than the new key
+  would, which keeps probe lengths short and even. A probe can then stop at the first slot
+  whose key is closer to home than the probe is. Removing shifts the following keys back,
+  so there are no tombstones
+*/
+template <typename T, typename J>
+struct Hashmap{
+    static_assert(sizeof(T) <= sizeof(u64), "Hashmap keys are integers or pointers");
+    T    *keys;
+    J    *values;
+    u32  *hashes;     //full hash of every key. Growing never hashes a key again
+    u8   *dists;      //probe length of the key in the slot + 1. 0 if the slot is empty
+    mem::Arena *arena;
+    u32   count;
+    u32   len;        //power of 2
+#if(HMAP_PROF)
+    u16   profId;
+#endif
+
+    void alloc(u32 slots MEM_SITE_PARAMS){
+	len = slots;
+	keys = (T*)mem::alloc(sizeof(T)*len, arena MEM_SITE_ARGS);
+	values = (J*)mem::alloc(sizeof(J)*len, arena MEM_SITE_ARGS);
+	hashes = (u32*)mem::alloc(sizeof(u32)*len, arena MEM_SITE_ARGS);
+	dists = (u8*)mem::alloc(len, arena MEM_SITE_ARGS);
+	memset(dists, 0, len);
+#if(HMAP_PROF)
+	hmapProf::onAlloc(profId, len);
+#endif
+    };
+    void init(u32 initialCapacity=10, mem::Arena *a=nullptr MEM_SITE_PARAMS){
+	u32 slots = 16;
+	while(initialCapacity > hmapMaxCount(slots)){slots <<= 1;};
+	count = 0;
+	arena = a;
+#if(HMAP_PROF)
+	profId = hmapProf::getSite("Hashmap", file, line);
+	hmapProf::sites[profId].tables += 1;
+#endif
+	alloc(slots MEM_SITE_ARGS);
+    };
+    void uninit(){
+	mem::free(keys, arena);
+	mem::free(values, arena);
+	mem::free(hashes, arena);
+	mem::free(dists, arena);
+    };
+    inline bool isFull(u32 slot){return dists[slot] != 0;};
+    u32 hashFunc(T key){return hashInt((u64)key);};
+    //slot of the key or len if it is not present
+    u32 find(T key, u32 hash){
+	u32 mask = len - 1;
+	u32 slot = hash & mask;
+	u32 dist = 1;
+	for(; dists[slot] >= dist; dist+=1){
+	    if(hashes[slot] == hash && key == keys[slot]){
+#if(HMAP_PROF)
+		hmapProf::onLookup(profId, dist, true);
+#endif
+		return slot;
 	    };
-	    len = newLen;
-	    keys = newKeys;
-	    values = newValues;
-	    status = newStatus;
+#if(HMAP_PROF)
+	    hmapProf::sites[profId].collisions += 1;
+#endif
+	    slot = (slot + 1) & mask;
 	};
-	if(_insert_value(key, value, len, status, keys, values)){
-	    count += 1;
-	    return true;
+#if(HMAP_PROF)
+	hmapProf::onLookup(profId, dist, false);
+#endif
+	return len;
+    };
+    bool getValue(T key, J *value){
+	u32 slot = find(key, hashFunc(key));
+	if(slot == len){return false;};
+	*value = values[slot];
+	return true;
+    };
+    /*
+      NOTE: on failure the probe got too long. key, value and hash then hold the entry
+      that still needs a slot, which may not be the one passed in
+    */
+    bool _insert_value(T &key, J &value, u32 &hash){
+	u32 mask = len - 1;
+	u32 slot = hash & mask;
+	u32 dist = 1;
+	while(isFull(slot)){
+	    if(dists[slot] < dist){
+		T tempKey = keys[slot];
+		J tempValue = values[slot];
+		u32 tempHash = hashes[slot];
+		u32 tempDist = dists[slot];
+		keys[slot] = key;
+		values[slot] = value;
+		hashes[slot] = hash;
+		dists[slot] = (u8)dist;
+		key = tempKey;
+		value = tempValue;
+		hash = tempHash;
+		dist = tempDist;
+	    };
+	    slot = (slot + 1) & mask;
+	    dist += 1;
+	    if(dist > HMAP_MAX_PROBE){return false;};
 	};
-	return false;
+	keys[slot] = key;
+	values[slot] = value;
+	hashes[slot] = hash;
+	dists[slot] = (u8)dist;
+	return true;
+    };
+    //rehashes the old slots, doubling the table again whenever a probe gets too long
+    void grow(){
+	T *oldKeys = keys;
+	J *oldValues = values;
+	u32 *oldHashes = hashes;
+	u8 *oldDists = dists;
+	u32 oldLen = len;
+	u32 slots = len;
+	bool done = false;
+#if(HMAP_PROF)
+	hmapProf::sites[profId].resizes += 1;
+#endif
+	while(!done){
+	    if(slots != oldLen){
+		mem::free(keys, arena);
+		mem::free(values, arena);
+		mem::free(hashes, arena);
+		mem::free(dists, arena);
+	    };
+	    slots <<= 1;
+	    alloc(slots);
+	    done = true;
+	    for(u32 x=0; x<oldLen && done; x+=1){
+		if(oldDists[x] == 0){continue;};
+		T key = oldKeys[x];
+		J value = oldValues[x];
+		u32 hash = oldHashes[x];
+		done = _insert_value(key, value, hash);
+	    };
+	};
+	mem::free(oldKeys, arena);
+	mem::free(oldValues, arena);
+	mem::free(oldHashes, arena);
+	mem::free(oldDists, arena);
+    };
+    bool insertValue(T key, J value){
+	if(count + 1 > hmapMaxCount(len)){grow();};
+	u32 hash = hashFunc(key);
+	while(!_insert_value(key, value, hash)){grow();};
+	count += 1;
+#if(HMAP_PROF)
+	hmapProf::sites[profId].inserts += 1;
+#endif
+	return true;
+    };
+    bool removeValue(T key){
+	u32 slot = find(key, hashFunc(key));
+	if(slot == len){return false;};
+	//shift the keys after it back by one, till one is already in its home slot
+	u32 mask = len - 1;
+	u32 next = (slot + 1) & mask;
+	while(dists[next] > 1){
+	    keys[slot] = keys[next];
+	    values[slot] = values[next];
+	    hashes[slot] = hashes[next];
+	    dists[slot] = dists[next] - 1;
+	    slot = next;
+	    next = (next + 1) & mask;
+	};
+	dists[slot] = 0;
+	count -= 1;
+#if(HMAP_PROF)
+	hmapProf::sites[profId].removes += 1;
+#endif
+	return true;
     };
 };
-//NOTE: only for int types
+/*
+  Hashmap that is emptied in O(1). A slot is full only if its stamp is the current
+  generation, so clearing bumps the generation instead of touching the slots.
+  NOTE: only for int types
+*/
 template <typename T, typename J>
-struct Hashmap{
+struct GenHashmap{
     T    *keys;
     J    *values;
-    bool *status;
+    u32  *hashes;     //full hash of every key. Growing never hashes a key again
+    u32  *gens;       //generation the slot was filled in
+    mem::Arena *arena;
+    u32   gen;        //never 0, so zeroed stamps are empty
     u32   count;
-    u32   len;
-    
-    void init(u32 initialCapacity=10){
-	len = initialCapacity;
+    u32   len;        //power of 2
+#if(HMAP_PROF)
+    u16   profId;
+#endif
+
+    void alloc(u32 slots MEM_SITE_PARAMS){
+	len = slots;
+	keys = (T*)mem::alloc(sizeof(T)*len, arena MEM_SITE_ARGS);
+	values = (J*)mem::alloc(sizeof(J)*len, arena MEM_SITE_ARGS);
+	hashes = (u32*)mem::alloc(sizeof(u32)*len, arena MEM_SITE_ARGS);
+	gens = (u32*)mem::alloc(sizeof(u32)*len, arena MEM_SITE_ARGS);
+	memset(gens, 0, sizeof(u32)*len);
+#if(HMAP_PROF)
+	hmapProf::onAlloc(profId, len);
+#endif
+    };
+    void init(u32 initialCapacity=10, mem::Arena *a=nullptr MEM_SITE_PARAMS){
+	u32 slots = 16;
+	while(initialCapacity > hmapMaxCount(slots)){slots <<= 1;};
 	count = 0;
-	keys = (T*)mem::alloc(sizeof(T)*len);
-	values = (J*)mem::alloc(sizeof(J)*len);
-	status = (bool*)mem::alloc(sizeof(bool)*len);
-	memset(status, false, sizeof(bool)*len);
+	gen = 1;
+	arena = a;
+#if(HMAP_PROF)
+	profId = hmapProf::getSite("GenHashmap", file, line);
+	hmapProf::sites[profId].tables += 1;
+#endif
+	alloc(slots MEM_SITE_ARGS);
     };
     void uninit(){
-	mem::free(keys);
-	mem::free(values);
-	mem::free(status);
+	mem::free(keys, arena);
+	mem::free(values, arena);
+	mem::free(hashes, arena);
+	mem::free(gens, arena);
     };
-    u32 hashFunc(char *key){
-	//fnv_hash_1a_32
-	u32 h = 0x811c9dc5;
-	for(u32 i=0; i<sizeof(T); i+=1){h = (h^key[i]) * 0x01000193;};
-	return h;
+    void clear(){
+	count = 0;
+	gen += 1;
+	if(gen == 0){
+	    //stamps from 2^32 clears ago would look full again
+	    memset(gens, 0, sizeof(u32)*len);
+	    gen = 1;
+	};
     };
+    inline bool isFull(u32 slot){return gens[slot] == gen;};
+    u32 hashFunc(T key){return hashInt((u64)key);};
     bool getValue(T key, J *value){
-	u32 startHash = hashFunc((char*)&key) % len;
-	u32 hash = startHash;
-	while(status[hash] == true){
-	    if(key == keys[hash]){
-		*value = values[hash];
+	u32 mask = len - 1;
+	u32 hash = hashFunc(key);
+#if(HMAP_PROF)
+	u32 probes = 1;
+#endif
+	//the load factor keeps a free slot to stop at
+	for(u32 slot = hash & mask; isFull(slot); slot = (slot + 1) & mask){
+	    if(hashes[slot] == hash && key == keys[slot]){
+		*value = values[slot];
+#if(HMAP_PROF)
+		hmapProf::onLookup(profId, probes, true);
+#endif
 		return true;
 	    };
-	    hash += 1;
-	    if(hash >= len){hash = 0;};
-	    if (hash == startHash){ return false; };
+#if(HMAP_PROF)
+	    hmapProf::sites[profId].collisions += 1;
+	    probes += 1;
+#endif
 	};
+#if(HMAP_PROF)
+	hmapProf::onLookup(profId, probes, false);
+#endif
 	return false;
     };
-    bool _insert_value(T key, J value, u32 length, bool *statusArr, T *keysArr, u32 *valuesArr){
-	u32 hash = hashFunc((char*)&key) % length;
-	while(statusArr[hash]){
-	    hash += 1;
-	    if(hash >= length){hash = 0;};
+    void _insert_value(T key, J value, u32 hash){
+	u32 mask = len - 1;
+	u32 slot = hash & mask;
+	while(isFull(slot)){slot = (slot + 1) & mask;};
+	gens[slot] = gen;
+	keys[slot] = key;
+	values[slot] = value;
+	hashes[slot] = hash;
+    };
+    void grow(){
+	T *oldKeys = keys;
+	J *oldValues = values;
+	u32 *oldHashes = hashes;
+	u32 *oldGens = gens;
+	u32 oldLen = len;
+#if(HMAP_PROF)
+	hmapProf::sites[profId].resizes += 1;
+#endif
+	alloc(len << 1);
+	for(u32 x=0; x<oldLen; x+=1){
+	    if(oldGens[x] != gen){continue;};
+	    _insert_value(oldKeys[x], oldValues[x], oldHashes[x]);
 	};
-	statusArr[hash] = true;
-	keysArr[hash] = key;
-	valuesArr[hash] = value;
-	return true;
+	mem::free(oldKeys, arena);
+	mem::free(oldValues, arena);
+	mem::free(oldHashes, arena);
+	mem::free(oldGens, arena);
     };
     bool insertValue(T key, J value){
-	if(count == len){
-	    u32 newLen = len + (u32)(len/2) + 10;
-	    T *newKeys = (T*)mem::alloc(sizeof(T)*newLen);
-	    J *newValues = (J*)mem::alloc(sizeof(u32)*newLen);
-	    bool *newStatus = (bool*)mem::alloc(sizeof(bool)*newLen);
-	    memset(newStatus, false, sizeof(bool)*newLen);
-	    for(u32 x=0; x<len; x+=1){
-		T tempKey = keys[x];
-		J val;
-		getValue(tempKey, &val);
-		_insert_value(tempKey, val, newLen, newStatus, newKeys, newValues);
-	    };
-	    len = newLen;
-	    keys = newKeys;
-	    values = newValues;
-	    status = newStatus;
-	};
-	if(_insert_value(key, value, len, status, keys, values)){
-	    count += 1;
-	    return true;
-	};
-	return false;
+	if(count + 1 > hmapMaxCount(len)){grow();};
+	_insert_value(key, value, hashFunc(key));
+	count += 1;
+#if(HMAP_PROF)
+	hmapProf::sites[profId].inserts += 1;
+#endif
+	return true;
     };
-};
\ No newline at end of file
+};
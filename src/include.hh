@@ -11,6 +11,9 @@
 #elif(LIN)
 #include <unistd.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 #endif
 
 #include "basic.hh"
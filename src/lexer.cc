@@ -1,9 +1,10 @@
-enum class TokType {
+//NOTE: one byte, so the parser's scans over the kinds stay small
+enum class TokType : u8 {
     END_OF_FILE,
 
     //room for ASCII chars
 
-    IDENTIFIER = 256,
+    IDENTIFIER = 128,
     INTEGER,
     DECIMAL,
     SINGLE_QUOTES,
@@ -41,17 +42,21 @@ enum class TokType {
     P_STACK_SIZE,
     P_END,       //poundwords end
 };
-struct TokenOffset {
-    u32 off;
-    u16 len;
-};
 
+/*
+  Keywords and poundwords are found with a perfect hash built at compile time:
+  one table probe and one compare per identifier, and nothing to build at startup
+*/
 namespace Word{
     struct WordData {
         const char *str;
         const TokType type;
+        const u32 len;
+
+        template<u32 N>
+        constexpr WordData(const char (&s)[N], TokType t) : str(s), type(t), len(N-1) {};
     };
-    const WordData keywordsData[] = {
+    constexpr WordData keywordsData[] = {
         {"u8", TokType::K_U8},
         {"char", TokType::K_CHAR},
         {"f32", TokType::K_F32},
@@ -73,25 +78,187 @@ namespace Word{
         {"else", TokType::K_ELSE},
         {"return", TokType::K_RETURN},
     };
-    const WordData poundwordsData[] = {
+    constexpr WordData poundwordsData[] = {
 	    {"import", TokType::P_IMPORT},
         {"stack_size", TokType::P_STACK_SIZE},
     };
-    HashmapStr keywords;
-    HashmapStr poundwords;
 
-    void init(HashmapStr &map, const WordData *data, const u32 count) {
-        map.init(count);
-        
-        for(u32 i = 0; i < count; i += 1){
-            map.insertValue({(char*)data[i].str, (u32)strlen(data[i].str) }, (u16)data[i].type);
+    //first 2 chars, last char and length. Distinct for every word above
+    constexpr u32 wordKey(const char *s, u32 len){
+        return (u32)(u8)s[0] | ((u32)(u8)s[(len > 1)?1:0] << 8) | ((u32)(u8)s[len-1] << 16) | (len << 24);
+    };
+    constexpr u32 wordSlot(u32 key, u32 seed, u32 bits){return (key * seed) >> (32 - bits);};
+
+    template<u32 bits>
+    struct PerfectHash{
+        u32 seed;                 //0 if no seed without collisions was found
+        u8  slots[1 << bits];     //index+1 in the word data, 0 if empty
+    };
+    //tries multipliers until every word lands in its own slot
+    template<u32 bits, u32 count>
+    constexpr PerfectHash<bits> makePerfectHash(const WordData (&data)[count]){
+        PerfectHash<bits> ph = {};
+        for(u32 seed = 0x9E3779B1; seed < 0x9E3779B1 + (1 << 16); seed += 2){
+            for(u32 x=0; x<(1 << bits); x++) ph.slots[x] = 0;
+            bool collision = false;
+            for(u32 x=0; x<count && !collision; x++){
+                u32 slot = wordSlot(wordKey(data[x].str, data[x].len), seed, bits);
+                if(ph.slots[slot]) collision = true;
+                else ph.slots[slot] = (u8)(x + 1);
+            };
+            if(!collision){
+                ph.seed = seed;
+                return ph;
+            };
         };
+        ph.seed = 0;
+        return ph;
+    };
+    constexpr PerfectHash<6> keywords = makePerfectHash<6>(keywordsData);
+    constexpr PerfectHash<2> poundwords = makePerfectHash<2>(poundwordsData);
+    static_assert(keywords.seed != 0, "no perfect hash for the keywords. Give the table more bits");
+    static_assert(poundwords.seed != 0, "no perfect hash for the poundwords. Give the table more bits");
+
+    template<u32 bits>
+    inline bool getType(const PerfectHash<bits> &ph, const WordData *data, char *str, u32 len, u32 *type){
+        u32 idx = ph.slots[wordSlot(wordKey(str, len), ph.seed, bits)];
+        if(idx == 0) return false;
+        const WordData &word = data[idx-1];
+        if(!cmpString({str, len}, {(char*)word.str, word.len})) return false;
+        *type = (u32)word.type;
+        return true;
     };
-    void uninit(HashmapStr &map){map.uninit();};
 };
 
+/*
+  Every distinct identifier gets a dense id once, while lexing. Name resolution
+  after that compares ids. Names are copied, so they outlive the source buffers
+*/
+namespace Symbol{
+    HashmapStr ids;                 //name to id
+    DynamicArray<String> names;     //id to name
+    mem::Arena arena;
+
+    u32 intern(String name){
+        u32 id;
+        if(ids.getValue(name, &id)) return id;
+        id = names.count;
+        String copy;
+        copy.len = name.len;
+        copy.mem = (char*)arena.alloc(name.len);
+        memcpy(copy.mem, name.mem, name.len);
+        names.push(copy);
+        ids.insertValue(copy, id);
+        return id;
+    };
+    inline String name(u32 id){return names[id];};
+    void init(){
+        arena.init();
+        ids.init(1024);
+        names.init(1024);
+        intern({(char*)"", 0});    //0 is never an identifier
+    };
+    void uninit(){
+        ids.uninit();
+        names.uninit();
+        arena.uninit();
+    };
+};
+
+/*
+  Files are lexed in dependency order and checked and lowered in reverse, so
+  both arenas are released LIFO: releasing a file also drops every file lexed after it
+*/
+static mem::Arena sourceArena;   //source buffers. Released after the file is lowered(string literals point into it)
+static mem::Arena tokenArena;    //token streams. Released after the file is checked
+
 bool isType(TokType type){return (type>TokType::K_TYPE_START && type<TokType::K_TYPE_END);};
+b32 isAlpha(char x){return (x >= 'a' && x <= 'z') || (x >= 'A' && x <= 'Z');};
+b32 isNum(char x){return (x >= '0' && x <= '9');};
+
+//zero bytes after the source. Vector scans may read this far past the last char
+#define SOURCE_PADDING 32
+//pshufb is SSSE3. Plain SIMD builds(no -march) take the scalar scans
+#define SIMD_CLASSES (SIMD && __SSSE3__)
+#if(SIMD_CLASSES)
+/*
+  Character classes looked up a vector at a time(pshufb). A byte is in a class if the
+  bit is set both in the entry of its low nibble and in the one of its high nibble.
+  Letters and whitespace span 2 rows of the ascii table, so they take 2 bits each
+*/
+#define CHAR_ALPHA_LO  0x01     //A-O a-o
+#define CHAR_ALPHA_HI  0x02     //P-Z p-z
+#define CHAR_DIGIT     0x04
+#define CHAR_WS_CTRL   0x08     //\t \r
+#define CHAR_WS_SPACE  0x10
+#define CHAR_UNDERSCORE 0x20
+#define CHAR_IDENT     (CHAR_ALPHA_LO | CHAR_ALPHA_HI | CHAR_DIGIT | CHAR_UNDERSCORE)
+#define CHAR_WS        (CHAR_WS_CTRL | CHAR_WS_SPACE)
+#define LO_NIBBLE_CLASSES 0x16, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x07, 0x0F, 0x03, 0x01, 0x01, 0x09, 0x01, 0x21
+#define HI_NIBBLE_CLASSES 0x08, 0x00, 0x10, 0x04, 0x01, 0x22, 0x01, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+//first offset at or after x whose char is not in any of the classes. The padding stops every scan
+inline u32 skipClass(const char *mem, u32 x, u8 classes){
+#if(__AVX2__)
+    const __m256i loTable = _mm256_setr_epi8(LO_NIBBLE_CLASSES, LO_NIBBLE_CLASSES);
+    const __m256i hiTable = _mm256_setr_epi8(HI_NIBBLE_CLASSES, HI_NIBBLE_CLASSES);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i wanted = _mm256_set1_epi8((char)classes);
+    while(true){
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(mem+x));
+        __m256i lo = _mm256_shuffle_epi8(loTable, _mm256_and_si256(chunk, nibble));
+        __m256i hi = _mm256_shuffle_epi8(hiTable, _mm256_and_si256(_mm256_srli_epi16(chunk, 4), nibble));
+        __m256i in = _mm256_and_si256(_mm256_and_si256(lo, hi), wanted);
+        u32 outside = (u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(in, _mm256_setzero_si256()));
+        if(outside) return x + ctz64(outside);
+        x += 32;
+    };
+#else
+    const __m128i loTable = _mm_setr_epi8(LO_NIBBLE_CLASSES);
+    const __m128i hiTable = _mm_setr_epi8(HI_NIBBLE_CLASSES);
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i wanted = _mm_set1_epi8((char)classes);
+    while(true){
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(mem+x));
+        __m128i lo = _mm_shuffle_epi8(loTable, _mm_and_si128(chunk, nibble));
+        __m128i hi = _mm_shuffle_epi8(hiTable, _mm_and_si128(_mm_srli_epi16(chunk, 4), nibble));
+        __m128i in = _mm_and_si128(_mm_and_si128(lo, hi), wanted);
+        u32 outside = (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(in, _mm_setzero_si128()));
+        if(outside) return x + ctz64(outside);
+        x += 16;
+    };
+#endif
+};
+#endif
+//end of the identifier whose first char is at x
+inline u32 skipIdentifier(char *mem, u32 x){
+#if(SIMD_CLASSES)
+    return skipClass(mem, x+1, CHAR_IDENT);
+#else
+    x += 1;
+    while (isAlpha(mem[x]) || mem[x] == '_' || isNum(mem[x])) x += 1;
+    return x;
+#endif
+};
+//end of the digits and '_' starting at x
+inline u32 skipDigits(char *mem, u32 x){
+#if(SIMD_CLASSES)
+    while(true){
+        x = skipClass(mem, x, CHAR_DIGIT);
+        if(mem[x] != '_') return x;
+        x += 1;
+    };
+#else
+    while(isNum(mem[x]) || mem[x] == '_') x += 1;
+    return x;
+#endif
+};
 u32 eatUnwantedChars(char *mem, u32 x){
+#if(SIMD_CLASSES)
+    //most runs are a single space, so only go wide when there is more
+    if(mem[x] != ' ' && mem[x] != '\r' && mem[x] != '\t') return x;
+    if(mem[x+1] != ' ' && mem[x+1] != '\r' && mem[x+1] != '\t') return x+1;
+    return skipClass(mem, x+2, CHAR_WS);
+#endif
     while (true) {
         switch (mem[x]) {
         case ' ':
@@ -106,46 +273,163 @@ u32 eatUnwantedChars(char *mem, u32 x){
     };
     return x;
 };
-b32 isAlpha(char x){return (x >= 'a' && x <= 'z') || (x >= 'A' && x <= 'Z');};
-b32 isNum(char x){return (x >= '0' && x <= '9');};
+#if(LIN)
+/*
+  Sources are mapped rather than read, so lexing starts without copying the file.
+  The mapping is laid out as [page ending in '\n'][file][zero page][guard page]:
+  the '\n' is the padding getLineAndOff expects before the first char, the rest of the
+  file's last page and the zero page are the SOURCE_PADDING, and the guard page stops
+  scans that run past it.
+  NOTE: pages are private and writable since reports edit the line they print(copy on write)
+*/
+char *mapSource(s32 fd, u64 size, u64 &mapLen){
+    u64 page = (u64)sysconf(_SC_PAGESIZE);
+    u64 fileLen = (size + page - 1) & ~(page - 1);
+    mapLen = page + fileLen + page + page;
+    char *base = (char*)mmap(nullptr, mapLen, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+    if(base == (char*)MAP_FAILED) return nullptr;
+    char *content = base + page;
+    if(mprotect(base, page, PROT_READ|PROT_WRITE) != 0 ||
+       mmap(content, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_FIXED, fd, 0) == MAP_FAILED ||
+       mprotect(content + fileLen, page, PROT_READ|PROT_WRITE) != 0){
+        munmap(base, mapLen);
+        return nullptr;
+    };
+    content[-1] = '\n';
+    //start reading ahead now, the lexer goes front to back
+    madvise(content, size, MADV_WILLNEED);
+    return content;
+};
+#endif
+//set in tokenValues when a line break comes before the token. There are no newline tokens
+#define TOKEN_NEWLINE 0x80000000
+//tokens are stored as parallel arrays, 9 bytes each
 struct Lexer {
-    DynamicArray<TokenOffset> tokenOffsets;
     DynamicArray<TokType> tokenTypes;
+    DynamicArray<u32> tokenOffsets;     //where the token starts in fileContent
+    DynamicArray<u32> tokenValues;      //symbol id of an identifier, length of any other token. Plus TOKEN_NEWLINE
     char *fileName;
     char *fileContent;
+    char *mapping;       //start of the mapped source. nullptr when the source was read into sourceArena
+    u64 mapLen;
+    mem::ArenaMark sourceMark;
+    mem::ArenaMark tokenMark;
 
+    //sources that can not tell their size up front(pipes, devices). Read till EOF
+    bool readStream(FILE *fp, u64 &size){
+        u64 cap = 4096;
+        char *buff = (char*)sourceArena.alloc(1 + cap + SOURCE_PADDING);
+        size = 0;
+        while(true){
+            size += fread(buff + 1 + size, sizeof(char), cap - size, fp);
+            if(ferror(fp)) return false;
+            if(size < cap) break;
+            u64 newCap = cap * 2;
+            if(!sourceArena.tryExtend(buff, 1 + cap + SOURCE_PADDING, 1 + newCap + SOURCE_PADDING)){
+                char *newBuff = (char*)sourceArena.alloc(1 + newCap + SOURCE_PADDING);
+                memcpy(newBuff, buff, 1 + size);
+                buff = newBuff;
+            };
+            cap = newCap;
+        };
+        buff[0] = '\n'; //padding for getLineAndOff
+        fileContent = buff + 1;
+        memset(fileContent + size, '\0', SOURCE_PADDING);
+        return true;
+    };
+    //fallback when the source can not be mapped
+    bool readSource(u64 &size){
+        FILE *fp = fopen(fileName, "r");
+        if(fp == nullptr) return false;
+        DEFER(fclose(fp));
+        if(fseek(fp, 0, SEEK_END) != 0) return false;
+        s64 end = ftell(fp);
+        if(end < 0 || fseek(fp, 0, SEEK_SET) != 0) return false;
+        size = end;
+        fileContent = (char*)sourceArena.alloc(1 + size + SOURCE_PADDING);
+        fileContent[0] = '\n'; //padding for getLineAndOff
+        fileContent += 1;
+        size = fread(fileContent, sizeof(char), size, fp);
+        if(ferror(fp)) return false;
+        memset(fileContent + size, '\0', SOURCE_PADDING);
+        return true;
+    };
     bool init(char *fn){
-        char tempBuff[100];
+        sourceMark = sourceArena.mark();
+        tokenMark = tokenArena.mark();
+        mapping = nullptr;
+        fileContent = nullptr;
 #if(WIN)
-        u32 len = GetFullPathNameA(fn, 1024, tempBuff, NULL);
+        u32 len = GetFullPathNameA(fn, 0, NULL, NULL);    //includes the null byte
+        if(len == 0) return false;
+        fileName = (char*)sourceArena.alloc(len);
+        GetFullPathNameA(fn, len, fileName, NULL);
 #elif(LIN)
-        char *fullpath = realpath(fn, tempBuff);
-        if(fullpath == nullptr) return 0;
+        char fullpath[PATH_MAX];
+        if(realpath(fn, fullpath) == nullptr) return false;
         u32 len = strlen(fullpath);
+        fileName = (char*)sourceArena.alloc(len + 1);
+        memcpy(fileName, fullpath, len+1);
 #endif
-        FILE *fp = fopen(tempBuff, "r");
-        fseek(fp, 0, SEEK_END);
-        u64 size = ftell(fp);
-        fseek(fp, 0, SEEK_SET);
-        fileName = (char*)mem::alloc(len + size + 17); //one for newline in the start, and 16 for SIMD padding(comments,etc...)
-        memcpy(fileName, tempBuff, len+1);
-
-        fileContent = fileName + len + 1;
-        fileContent[0] = '\n'; //padding for getLineAndOff
-        fileContent += 1;
-        size = fread(fileContent, sizeof(char), size, fp);
-        memset(fileContent + size, '\0', 16);
+        u64 size = 0;
+#if(LIN)
+        s32 fd = open(fileName, O_RDONLY);
+        if(fd != -1){
+            struct stat info;
+            if(fstat(fd, &info) != 0){
+                close(fd);
+                return false;
+            };
+            if(!S_ISREG(info.st_mode)){
+                //pipes and the like are read till EOF through this fd, they can not be opened twice
+                FILE *fp = fdopen(fd, "r");
+                if(fp == nullptr){
+                    close(fd);
+                    return false;
+                };
+                bool read = readStream(fp, size);
+                fclose(fp);
+                if(!read) return false;
+            }else{
+                //empty files can not be mapped
+                if(info.st_size > 0){
+                    size = info.st_size;
+                    fileContent = mapSource(fd, size, mapLen);
+                    if(fileContent) mapping = fileContent - sysconf(_SC_PAGESIZE);
+                };
+                close(fd);
+            };
+        };
+#endif
+        if(fileContent == nullptr && !readSource(size)) return false;
 
         //50% of the file size. @foodforthought: change percentage?
         u32 tokenCount = (u32)((50 * size) / 100) + 1;
-        tokenTypes.init(tokenCount);
-        tokenOffsets.init(tokenCount);
+        tokenTypes.init(tokenCount, &tokenArena);
+        tokenOffsets.init(tokenCount, &tokenArena);
+        tokenValues.init(tokenCount, &tokenArena);
         return true;
     };
+    //NOTE: tokens are not needed after checking. Files lexed after this one must already be released
+    void releaseTokens(){
+        tokenArena.release(tokenMark);
+        tokenTypes.zero();
+        tokenOffsets.zero();
+        tokenValues.zero();
+    };
+    //NOTE: diagnostics point into the source, so only release it once no more reports can be made for this file
+    void releaseSource(){
+#if(LIN)
+        if(mapping) munmap(mapping, mapLen);
+#endif
+        mapping = nullptr;
+        sourceArena.release(sourceMark);
+        fileName = nullptr;
+        fileContent = nullptr;
+    };
     void uninit(){
-        mem::free(fileName);
-        tokenTypes.uninit();
-        tokenOffsets.uninit();
+        releaseTokens();
+        releaseSource();
     };
     void emitErr(u32 off, char *fmt, ...) {
         if(report::errorOff == MAX_ERRORS) return;
@@ -160,11 +444,28 @@ struct Lexer {
         report::reportBuffTop += vsprintf(report::reportBuff, fmt, args);
         va_end(args);
     };
+    inline void pushToken(TokType type, u32 off, u32 value, u32 flags){
+        tokenOffsets.push(off);
+        tokenValues.push(value | flags);
+        tokenTypes.push(type);
+    };
+    inline u32 tokenValue(u32 x){return tokenValues[x] & ~TOKEN_NEWLINE;};
+    inline bool startsLine(u32 x){return tokenValues[x] & TOKEN_NEWLINE;};
+    u32 tokenLen(u32 x){
+        if(tokenTypes[x] == TokType::IDENTIFIER) return Symbol::name(tokenValue(x)).len;
+        return tokenValue(x);
+    };
     b32 genTokens() {
         char *src = fileContent;
         u32 x = eatUnwantedChars(src, 0);
+        u32 newLine = 0;   //TOKEN_NEWLINE until the next token is pushed
         while (src[x] != '\0') {
             switch (src[x]) {
+            case '\n':{
+                newLine = TOKEN_NEWLINE;
+                x = eatUnwantedChars(src, x+1);
+                continue;
+            }break;
             case '#':{
                 x += 1;
                 u32 start = x;
@@ -174,15 +475,11 @@ struct Lexer {
                     return false;
                 }
                 u32 type;
-                if(Word::poundwords.getValue({src+start, x-start}, &type) == false){
+                if(Word::getType(Word::poundwords, Word::poundwordsData, src+start, x-start, &type) == false){
                     emitErr(start, "Unkown poundword");
                     return false;
                 };
-                tokenTypes.push((TokType)type);
-                TokenOffset offset;
-                offset.off = start;
-                offset.len = (u16)(x-start);
-                tokenOffsets.push(offset);
+                pushToken((TokType)type, start, x-start, newLine);
             }break;
             case '\'':{
                 x += 1;
@@ -190,11 +487,7 @@ struct Lexer {
                     emitErr(x-1, "Expected ending single quotes");
                     return false;
                 };
-                tokenTypes.push(TokType::SINGLE_QUOTES);
-                TokenOffset offset;
-                offset.off = x;
-                offset.len = 1;
-                tokenOffsets.push(offset);
+                pushToken(TokType::SINGLE_QUOTES, x, 1, newLine);
                 x += 2;
             } break;
             case '\"':{
@@ -209,31 +502,21 @@ struct Lexer {
                     };
                 };
                 if(src[x-1] == '\\') goto DOUBLE_QUOTE_FIND_END;
-                tokenTypes.push(TokType::DOUBLE_QUOTES);
-                TokenOffset offset;
-                offset.off = start;
-                offset.len = (u16)(x-start);
-                tokenOffsets.push(offset);
+                pushToken(TokType::DOUBLE_QUOTES, start, x-start, newLine);
                 x++;
             } break;
             default: {
             if (isAlpha(src[x]) || src[x] == '_') {
                 u32 start = x;
-                x += 1;
-                while (isAlpha(src[x]) || src[x] == '_' || isNum(src[x])) x += 1;
+                x = skipIdentifier(src, x);
                 u32 type;
-                if(Word::keywords.getValue({src+start, (u32)(x-start)}, &type) != false){ tokenTypes.push((TokType)type);}
-                else{tokenTypes.push(TokType::IDENTIFIER);};
-                TokenOffset offset;
-                offset.off = start;
-                offset.len = (u16)(x-start);
-                tokenOffsets.push(offset);
+                if(Word::getType(Word::keywords, Word::keywordsData, src+start, x-start, &type) != false) pushToken((TokType)type, start, x-start, newLine);
+                else pushToken(TokType::IDENTIFIER, start, Symbol::intern({src+start, (u32)(x-start)}), newLine);
             } else if (isNum(src[x])) {
                 u32 start = x;
                 TokType numType = TokType::INTEGER;
             CHECK_NUM_DEC:
-                x += 1;
-                while(isNum(src[x]) || src[x] == '_') x += 1;
+                x = skipDigits(src, x+1);
                 if(src[x] == '.' && src[x+1] != '.'){
                     if(numType == TokType::DECIMAL){
                         emitErr(start, "Decimal cannot have 2 decimals");
@@ -242,14 +525,13 @@ struct Lexer {
                     numType = TokType::DECIMAL;
                     goto CHECK_NUM_DEC;
                 };
-                TokenOffset offset;
-                offset.off = start;
-                offset.len = (u16)(x-start);
-                tokenOffsets.push(offset);
-                tokenTypes.push(numType);
+                pushToken(numType, start, x-start, newLine);
             } else {
-                TokenOffset offset;
-                offset.off = x;
+                u32 start = x;
+                if((u8)src[x] >= (u8)TokType::IDENTIFIER){
+                    emitErr(x, "Unexpected character");
+                    return false;
+                };
                 TokType type = (TokType)src[x];
                 if(src[x] == '.'){
                     if(src[x+1] == '.'){
@@ -294,6 +576,8 @@ struct Lexer {
                 };
                 x += 1;		
 #endif
+                //the comment ate the line break
+                newLine = TOKEN_NEWLINE;
                 x = eatUnwantedChars(src, x);
                 continue;
                 } else if (src[x] == '/' && src[x+1] == '*') {
@@ -380,17 +664,16 @@ struct Lexer {
                 x = eatUnwantedChars(src, x);
                 continue;
                 };
-                tokenOffsets.push(offset);
-                tokenTypes.push(type);
+                pushToken(type, start, x-start+1, newLine);
                 x += 1;
             };
             } break;
             };
+            newLine = 0;
             x = eatUnwantedChars(src, x);
         };
         LEXER_EMIT_END_OF_FILE:
-        tokenTypes.push(TokType::END_OF_FILE);
-        tokenOffsets.push({ x, 0 });
+        pushToken(TokType::END_OF_FILE, x, 0, newLine);
         return true;
     };
 };
@@ -400,29 +683,29 @@ namespace dbg {
     void dumpLexerTokens(Lexer &lexer) {
         for (u32 x = 0; x < lexer.tokenTypes.count; x += 1) {
             printf("\n-----[TOKEN]-----\n");
+            if(lexer.startsLine(x)) printf("new_line ");
             switch (lexer.tokenTypes[x]) {
             case TokType::DOUBLE_QUOTES: {
-            printf("double_quotes: %.*s", lexer.tokenOffsets[x].len, lexer.fileContent + lexer.tokenOffsets[x].off);
+            printf("double_quotes: %.*s", lexer.tokenLen(x), lexer.fileContent + lexer.tokenOffsets[x]);
             } break;
             case TokType::SINGLE_QUOTES: {
-            printf("single_quotes: %.*s", lexer.tokenOffsets[x].len, lexer.fileContent + lexer.tokenOffsets[x].off);
+            printf("single_quotes: %.*s", lexer.tokenLen(x), lexer.fileContent + lexer.tokenOffsets[x]);
             } break;
             case TokType::IDENTIFIER: {
-            printf("identifier: %.*s", lexer.tokenOffsets[x].len, lexer.fileContent + lexer.tokenOffsets[x].off);
+            printf("identifier: %.*s", lexer.tokenLen(x), lexer.fileContent + lexer.tokenOffsets[x]);
             } break;
             case TokType::INTEGER: {
-            printf("integer: %.*s", lexer.tokenOffsets[x].len, lexer.fileContent + lexer.tokenOffsets[x].off);
+            printf("integer: %.*s", lexer.tokenLen(x), lexer.fileContent + lexer.tokenOffsets[x]);
             } break;
             case TokType::DECIMAL: {
-            printf("decimal: %.*s", lexer.tokenOffsets[x].len, lexer.fileContent + lexer.tokenOffsets[x].off);
+            printf("decimal: %.*s", lexer.tokenLen(x), lexer.fileContent + lexer.tokenOffsets[x]);
             } break;
             case TokType::END_OF_FILE: printf("end_of_file"); break;
-            case (TokType)'\n': printf("new_line"); break;
             default:
             if(lexer.tokenTypes[x] > TokType::K_START && lexer.tokenTypes[x] < TokType::K_END){
-                printf("keyword: %.*s", lexer.tokenOffsets[x].len, lexer.fileContent + lexer.tokenOffsets[x].off);
+                printf("keyword: %.*s", lexer.tokenLen(x), lexer.fileContent + lexer.tokenOffsets[x]);
             }else if(lexer.tokenTypes[x] > TokType::P_START && lexer.tokenTypes[x] < TokType::P_END){
-                printf("poundword: %.*s", lexer.tokenOffsets[x].len, lexer.fileContent + lexer.tokenOffsets[x].off);
+                printf("poundword: %.*s", lexer.tokenLen(x), lexer.fileContent + lexer.tokenOffsets[x]);
             }else{
                 printf("%c", (char)lexer.tokenTypes[x]);
             };
@@ -21,20 +21,32 @@ s32 main(s32 argc, char **argv){
     char *outputPath = "out.asm";
     if(argc == 3) outputPath = argv[2];
 
-    Word::init(Word::keywords, Word::keywordsData, ARRAY_LENGTH(Word::keywordsData));
-    Word::init(Word::poundwords, Word::poundwordsData, ARRAY_LENGTH(Word::poundwordsData));
+    Symbol::init();
+    sourceArena.init();
+    tokenArena.init();
+    astArena.init(AST_PAGE_SIZE);
+    checkerArena.init();
+    varEntityPool.init();
+    procEntityPool.init();
+    structScopePool.init();
+    asmArena.init();
     linearDepEntities.init();
     linearDepStrings.init();
 
     FileEntity &mainFileEntity = linearDepEntities.newElem();
 
-    mainFileEntity.lexer.init(inputPath);
+    mem::phase("lexer");
+    if(!mainFileEntity.lexer.init(inputPath)){
+        printf("Could not read %s\n", inputPath);
+        return EXIT_FAILURE;
+    };
     mainFileEntity.file.init();
 
     if(!mainFileEntity.lexer.genTokens()){
         report::flushReports();
         return EXIT_SUCCESS;
     };
+    mem::phase("parser");
     if(!parseFile(mainFileEntity.lexer, mainFileEntity.file)){
         report::flushReports();
         return EXIT_SUCCESS;
@@ -43,30 +55,36 @@ s32 main(s32 argc, char **argv){
         String path = linearDepStrings[x];
         char c = path.mem[path.len];
         path.mem[path.len] = '\0';
+        mem::phase("lexer");
         FileEntity &fe = linearDepEntities.newElem();
-        fe.lexer.init(path.mem);
+        if(!fe.lexer.init(path.mem)){
+            printf("Could not read %s\n", path.mem);
+            return EXIT_FAILURE;
+        };
         fe.file.init();
         path.mem[path.len] = c;
         if(!fe.lexer.genTokens()){
             report::flushReports();
             return EXIT_SUCCESS;
         };
+        mem::phase("parser");
         if(!parseFile(fe.lexer, fe.file)){
             report::flushReports();
             return EXIT_SUCCESS;
         };
     };
+    mem::phase("checker");
     u32 dependencyCount = linearDepEntities.count;
     globalScopes = (Scope*)mem::alloc(sizeof(Scope) * dependencyCount);
     memset(globalScopes, 0, sizeof(Scope) * dependencyCount);
-    scopeAllocMem = (Scope*)mem::alloc(sizeof(Scope)*1000);
-    structScopeAllocMem = (Scope*)mem::alloc(sizeof(Scope)*100);
     struc.init();
+    symbols.init(Symbol::names.count);
     strucs.init();
     DynamicArray<ASTBase*> globals;
     globals.init();
     stringToId.init();
     DEFER({
+        dumpHashmapStats();
         mem::uninit();     //NOTE: this free all the memory that was allocated before
         printf("\nDone :)\n");
     });
@@ -85,9 +103,9 @@ s32 main(s32 argc, char **argv){
             report::flushReports();
             return EXIT_SUCCESS;
         };
-        for(u32 x=0; x<scopeOff; x++) scopeAllocMem[x].uninit();
-        scopeOff = 0;
+        fe.lexer.releaseTokens();
     };
+    mem::phase("riscv");
     lowerToRISCV(outputPath, globals);
     return EXIT_SUCCESS;
 };
\ No newline at end of file
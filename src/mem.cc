@@ -2,96 +2,666 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
-#if(DBG)
+#include <atomic>
+#if(DBG || MEM_PROF || HMAP_PROF)
 #include <stdio.h>
 #endif
+#if(WIN)
+#include "windows.h"
+#elif(LIN)
+#include <sys/mman.h>
+#endif
 
 #define CHUNK_SIZE  (sizeof(u64)*2)
 #define CHUNK_COUNT 10000000
+#define SMALL_CLASS_COUNT 128        //allocations upto 128 chunks(2KB) get their own free list
+#define NO_CHUNK    0xFFFFFFFF
+#define STAT_WORDS  (CHUNK_COUNT/64 + 1)
+#define COMMIT_STEP 65536            //chunks(1MB) committed at once as the pool grows
+#define HUGE_PAGE_SIZE (2*1024*1024)
+#define POOL_SIZE   (((CHUNK_SIZE*CHUNK_COUNT) + HUGE_PAGE_SIZE - 1) & ~(u64)(HUGE_PAGE_SIZE - 1))
+#define MAX_HEAPS   64               //one heap per thread that allocates
+#define HEAP_SHIFT  24               //allocation header: heap id in the top 8 bits, chunk count in the rest
+#define CHUNK_MASK  ((1 << HEAP_SHIFT) - 1)
+
+static_assert(CHUNK_COUNT <= CHUNK_MASK, "chunk count does not fit in the allocation header");
+
+#ifdef _MSC_VER
+#include <intrin.h>
+inline u32 ctz64(u64 x){
+    unsigned long i;
+    _BitScanForward64(&i, x);
+    return i;
+};
+#define popcount64 __popcnt64
+#else
+#define ctz64 __builtin_ctzll
+#define popcount64 __builtin_popcountll
+#endif
+
+//MEM_PROF builds record the call site of every allocation, HMAP_PROF builds the one of every hash table
+#if(MEM_PROF || HMAP_PROF)
+#define MEM_SITE_PARAMS , const char *file = __builtin_FILE(), u32 line = __builtin_LINE()
+#define MEM_SITE_ARGS   , file, line
+#else
+#define MEM_SITE_PARAMS
+#define MEM_SITE_ARGS
+#endif
 
 namespace allocator{
-    void *alloc(u64 size, char *memory, bool *stat){
+    /*
+      The pool only reserves address space upfront. Pages are committed(and
+      poisoned in debug builds) as the top of the pool grows, so startup cost
+      does not depend on CHUNK_COUNT
+    */
+    char *reserve(u64 size){
+#if(WIN)
+	return (char*)VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_READWRITE);
+#elif(LIN)
+	//anonymous pages are zero filled and backed by the kernel only on first touch
+	void *ptr = mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+	if(ptr == MAP_FAILED){return nullptr;};
+	return (char*)ptr;
+#else
+	return (char*)::calloc(size, 1);
+#endif
+    };
+#if(HUGE_PAGES)
+    /*
+      Opt-in(build with -D HUGE_PAGES=1) backing of the pool with 2MB pages to
+      cut dTLB misses. Tries explicit huge pages first, then transparent huge
+      pages. Returns nullptr when neither is available so the caller can fall
+      back to reserve
+    */
+    char *reserveHuge(u64 size){
+#if(WIN)
+	//large pages can not be committed lazily and need SeLockMemoryPrivilege
+	u64 page = GetLargePageMinimum();
+	if(page == 0){return nullptr;};
+	size = (size + page - 1) & ~(page - 1);
+	return (char*)VirtualAlloc(NULL, size, MEM_RESERVE|MEM_COMMIT|MEM_LARGE_PAGES, PAGE_READWRITE);
+#elif(LIN)
+	void *ptr = mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+	if(ptr != MAP_FAILED){return (char*)ptr;};
+#if defined(MADV_HUGEPAGE)
+	//THP only kicks in for 2MB aligned ranges, so over reserve and trim
+	char *raw = (char*)mmap(nullptr, size + HUGE_PAGE_SIZE, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_NORESERVE, -1, 0);
+	if(raw == (char*)MAP_FAILED){return nullptr;};
+	char *aligned = (char*)(((u64)raw + HUGE_PAGE_SIZE - 1) & ~(u64)(HUGE_PAGE_SIZE - 1));
+	if(aligned != raw){munmap(raw, aligned - raw);};
+	munmap(aligned + size, (raw + size + HUGE_PAGE_SIZE) - (aligned + size));
+	if(madvise(aligned, size, MADV_HUGEPAGE) != 0){
+	    munmap(aligned, size);
+	    return nullptr;
+	};
+	return aligned;
+#else
+	return nullptr;
+#endif
+#else
+	return nullptr;
+#endif
+    };
+#endif
+    bool commit(char *ptr, u64 size){
+#if(WIN)
+	return VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+	return true;
+#endif
+    };
+    void release(char *ptr, u64 size){
+#if(WIN)
+	VirtualFree(ptr, 0, MEM_RELEASE);
+#elif(LIN)
+	munmap(ptr, size);
+#else
+	::free(ptr);
+#endif
+    };
+    //stat is a bitmap with 1 bit per chunk. 1 = chunk is in use
+    void mark(u64 *stat, u32 off, u32 count, bool used){
+	while(count != 0){
+	    u32 bit = off & 63;
+	    u32 n = 64 - bit;
+	    if(n > count){n = count;};
+	    u64 mask = (n == 64)?~(u64)0:(((u64)1 << n) - 1) << bit;
+	    if(used){stat[off>>6] |= mask;}
+	    else{stat[off>>6] &= ~mask;};
+	    off += n;
+	    count -= n;
+	};
+    };
+    //returns the first chunk in [off, end) whose bit equals used, or end
+    u32 find(u64 *stat, u32 off, u32 end, bool used){
+	u64 flip = used?0:~(u64)0;
+	while(off < end){
+	    u64 word = (stat[off>>6] ^ flip) >> (off&63);
+	    if(word != 0){
+		off += ctz64(word);
+		return (off < end)?off:end;
+	    };
+	    off = (off | 63) + 1;
+	};
+	return end;
+    };
+
+    struct Pool{
+	char *memory;
+	u64  *stat;
+	u32   top;                                 //chunks at and after top were never handed out
+	u32   largeHint;                           //lowest chunk freed by the large-object path
+	u32   largeFree;                           //chunks freed by the large-object path below top
+	u32   committed;                           //chunks before this are committed
+	u32   heapId;
+#if(MEM_COUNT)
+	u64   allocs;                              //pool allocations and arena bumps served. Read by bench/ds.cc
+#endif
+	u32   freeList[SMALL_CLASS_COUNT+1];       //head chunk of each size class(index = chunk count)
+	std::atomic<u32> remoteFree;               //head chunk of the allocations other threads freed
+    };
+
+    inline u32 chunksOf(u32 header){return header & CHUNK_MASK;};
+    //chunks needed for an allocation of size bytes(header included)
+    inline u32 chunksFor(u64 size){return ceil((size + sizeof(u32))/((double)(CHUNK_SIZE)));};
+    inline u32 heapOf(u32 header){return header >> HEAP_SHIFT;};
+    void init(Pool &pool, char *memory, u64 *stat, u32 heapId){
+	pool.heapId = heapId;
+	pool.remoteFree = NO_CHUNK;
+	pool.memory = memory;
+	pool.stat = stat;
+	pool.top = 0;
+	pool.largeHint = CHUNK_COUNT;
+	pool.largeFree = 0;
+	pool.committed = 0;
+#if(MEM_COUNT)
+	pool.allocs = 0;
+#endif
+	for(u32 x=0; x<=SMALL_CLASS_COUNT; x+=1){pool.freeList[x] = NO_CHUNK;};
+    };
+    inline void *handOut(Pool &pool, u32 startOff, u32 chunkReq){
+	char *ptr = pool.memory+(startOff*CHUNK_SIZE);
+	u32 *intPtr = (u32*)ptr;
+	*intPtr = chunkReq | (pool.heapId << HEAP_SHIFT);
+	return (void*)(ptr + sizeof(u32));
+    };
+    bool commitUpto(Pool &pool, u32 end){
+	if(end <= pool.committed){return true;};
+	u32 newCommitted = end + COMMIT_STEP - (end % COMMIT_STEP);
+	if(newCommitted > CHUNK_COUNT){newCommitted = CHUNK_COUNT;};
+	char *start = pool.memory + (u64)pool.committed*CHUNK_SIZE;
+	u64 size = (u64)(newCommitted - pool.committed)*CHUNK_SIZE;
+	if(!commit(start, size)){
+#if(DBG)
+	    printf("\n[MEM]: could not commit memory\n");
+#endif
+	    return false;
+	};
+#if(DBG)
+	memset(start, 'A', size);
+#endif
+	pool.committed = newCommitted;
+	return true;
+    };
+    inline void *bump(Pool &pool, u32 chunkReq){
+	if(pool.top+chunkReq >= CHUNK_COUNT){
+#if(DBG)
+	    printf("\n[MEM]: out of chunks. Please increase CHUNK_COUNT\n");
+#endif
+	    return nullptr;
+	};
+	if(!commitUpto(pool, pool.top+chunkReq)){return nullptr;};
+	u32 startOff = pool.top;
+	pool.top += chunkReq;
+	mark(pool.stat, startOff, chunkReq, true);
+	return handOut(pool, startOff, chunkReq);
+    };
+    void *allocLarge(Pool &pool, u32 chunkReq){
+	/*
+	  Large allocations are rare(token arrays, big tables), so they are
+	  served first-fit from the holes that earlier large frees left behind.
+	  When there are no such holes we bump from the top
+	*/
+	if(pool.largeFree < chunkReq){return bump(pool, chunkReq);};
+	u32 i = find(pool.stat, pool.largeHint, pool.top, false);
+	pool.largeHint = i;
+	while(i < pool.top){
+	    u32 end = find(pool.stat, i, pool.top, true);
+	    if(end - i >= chunkReq){
+		if(i == pool.largeHint){pool.largeHint = i + chunkReq;};
+		pool.largeFree -= chunkReq;
+		mark(pool.stat, i, chunkReq, true);
+		return handOut(pool, i, chunkReq);
+	    };
+	    if(end == pool.top){
+		//the hole touches the top, so grow it instead of searching further
+		if(i+chunkReq >= CHUNK_COUNT){break;};
+		if(!commitUpto(pool, i+chunkReq)){return nullptr;};
+		pool.largeFree -= end - i;
+		if(i == pool.largeHint){pool.largeHint = i + chunkReq;};
+		pool.top = i + chunkReq;
+		mark(pool.stat, i, chunkReq, true);
+		return handOut(pool, i, chunkReq);
+	    };
+	    i = find(pool.stat, end, pool.top, false);
+	};
+	return bump(pool, chunkReq);
+    };
+    void free(void *ptr, Pool &pool);
+    void drainRemote(Pool &pool){
+	u32 off = pool.remoteFree.exchange(NO_CHUNK, std::memory_order_acquire);
+	while(off != NO_CHUNK){
+	    char *ptr = pool.memory+(off*CHUNK_SIZE)+sizeof(u32);
+	    off = *(u32*)ptr;
+	    free(ptr, pool);
+	};
+    };
+    void *alloc(u64 size, Pool &pool){
 #if(DBG)
 	if(size == 0){
 	    printf("\n[MEM]: trying to allocate memory of size 0\n");
 	    return nullptr;
 	};
+#endif
+	if(pool.remoteFree.load(std::memory_order_relaxed) != NO_CHUNK){drainRemote(pool);};
+#if(MEM_COUNT)
+	pool.allocs += 1;
 #endif
 	/*
 	  Each allocation remembers the amount of blocks it asked for
 	  This decreases cache miss
 	*/
-	size += sizeof(u32);
-	u32 chunkReq = ceil(size/((double)(CHUNK_SIZE)));
-	u32 i = 0;
-    MEM_FIND_CHUNKS:
-	u32 startOff = i;
-	u32 chunkFound = 0;
-	while(stat[i] == false){
-	    chunkFound += 1;
-	    if(chunkFound == chunkReq){
-		char *ptr = memory+(startOff*CHUNK_SIZE);
-		u32 *intPtr = (u32*)ptr;
-		*intPtr = chunkReq;
-		ptr += sizeof(u32);
-		memset(&stat[startOff], true, sizeof(bool) * chunkFound);
-		return(void*)ptr;
-	    };
-	    i += 1;
-	};
-	if(i+chunkReq >= CHUNK_COUNT){
-#if(DBG)
-	    printf("\n[MEM]: out of chunks. Please increase CHUNK_COUNT\n");
-#endif
-	    return nullptr;
-	};
-	while(stat[i]){i += 1;};
-	goto MEM_FIND_CHUNKS;
-	return nullptr;
+	u32 chunkReq = chunksFor(size);
+	if(chunkReq > SMALL_CLASS_COUNT){return allocLarge(pool, chunkReq);};
+	u32 startOff = pool.freeList[chunkReq];
+	if(startOff == NO_CHUNK){return bump(pool, chunkReq);};
+	//free chunks keep the next chunk of their list right after the header
+	pool.freeList[chunkReq] = *(u32*)(pool.memory+(startOff*CHUNK_SIZE)+sizeof(u32));
+	return handOut(pool, startOff, chunkReq);
     };
-    void free(void *ptr, char *memory, bool *stat){
+    void free(void *ptr, Pool &pool){
 	char *cptr = (char*)ptr;
 	cptr -= sizeof(u32);
-	u32 off = (cptr - memory)/CHUNK_SIZE;
-	u32 chunks = *((u32*)cptr);
-	memset(&stat[off], false, sizeof(bool)*chunks);
+	u32 off = (cptr - pool.memory)/CHUNK_SIZE;
+	u32 header = *((u32*)cptr);
+	u32 chunks = chunksOf(header);
 #if(DBG)
 	memset(cptr, 'A', CHUNK_SIZE*chunks);
+	*((u32*)cptr) = header;
 #endif
+	if(chunks <= SMALL_CLASS_COUNT){
+	    //chunks stay marked in stat as they are owned by the size class
+	    *(u32*)(cptr+sizeof(u32)) = pool.freeList[chunks];
+	    pool.freeList[chunks] = off;
+	    return;
+	};
+	mark(pool.stat, off, chunks, false);
+	if(off+chunks == pool.top){
+	    pool.top = off;
+	    return;
+	};
+	pool.largeFree += chunks;
+	if(off < pool.largeHint){pool.largeHint = off;};
+    };
+    //grows the allocation at ptr to chunkReq chunks without moving it, if the chunks after it are free
+    bool tryExtend(void *ptr, u32 chunkReq, Pool &pool){
+	u32 *header = (u32*)ptr - 1;
+	u32 chunks = chunksOf(*header);
+	if(chunkReq <= chunks){return true;};
+	u32 off = ((char*)header - pool.memory)/CHUNK_SIZE;
+	u32 start = off + chunks;
+	u32 end = off + chunkReq;
+	if(end >= CHUNK_COUNT){return false;};
+	//chunks of small class free lists stay marked, so only truly free chunks pass this
+	u32 belowTop = (end < pool.top)?end:pool.top;
+	if(start < belowTop && find(pool.stat, start, belowTop, true) != belowTop){return false;};
+	if(end > pool.top){
+	    if(!commitUpto(pool, end)){return false;};
+	    pool.largeFree -= pool.top - start;
+	    pool.top = end;
+	}else{pool.largeFree -= end - start;};
+	mark(pool.stat, start, end - start, true);
+	*header = chunkReq | (pool.heapId << HEAP_SHIFT);
+	return true;
+    };
+    //called by a thread that does not own pool. The owner frees it on its next alloc
+    void freeRemote(void *ptr, Pool &pool){
+	char *cptr = (char*)ptr;
+	u32 off = (cptr - sizeof(u32) - pool.memory)/CHUNK_SIZE;
+	u32 head = pool.remoteFree.load(std::memory_order_relaxed);
+	do{
+	    *(u32*)cptr = head;
+	}while(!pool.remoteFree.compare_exchange_weak(head, off, std::memory_order_release, std::memory_order_relaxed));
     };
 };
 namespace mem{
-    char *memory;
-    bool *stat;
+    /*
+      Every thread allocates from its own heap, created on its first
+      allocation. Frees from a thread that does not own the allocation are
+      queued on the owner, which takes them back on its next alloc.
+      When a thread exits its heap is orphaned(its allocations may still be
+      alive) and the next thread that needs a heap adopts it
+    */
+    enum HeapState : u32{
+	HEAP_FREE,          //no memory behind the slot
+	HEAP_SETUP,         //being reserved by newHeap
+	HEAP_OWNED,
+	HEAP_ORPHANED,      //owner exited. Memory is kept for the next owner
+    };
+    allocator::Pool heaps[MAX_HEAPS];
+    std::atomic<u32> heapStates[MAX_HEAPS];
+    thread_local allocator::Pool *localHeap = nullptr;
+    //hands the heap back when its thread exits
+    struct HeapOwner{
+	allocator::Pool *heap = nullptr;
+	~HeapOwner(){
+	    if(heap == nullptr){return;};
+	    allocator::drainRemote(*heap);
+	    heapStates[heap->heapId].store(HEAP_ORPHANED, std::memory_order_release);
+	    heap = nullptr;
+	};
+    };
+    thread_local HeapOwner heapOwner;
 #if(DBG)
-    u32 allocCount;
+    std::atomic<u32> allocCount;
 #endif
+
+#if(MEM_PROF)
+#define MAX_PROF_SITES  1024
+#define MAX_PROF_PHASES 16
+    /*
+      Opt-in allocation profiler(build with -D MEM_PROF=1). Every allocation
+      carries a Tag in front of it so that frees can be charged back to the
+      call site and phase that allocated it. Arena bumps have no tag, they
+      get their own tables(bytes handed out per call site and phase) and the
+      blocks behind them show up under mem.cc in the pool tables.
+      Counters are not synchronized, so numbers are only exact for single threaded runs
+    */
+    namespace prof{
+	struct Stat{
+	    u64 allocated;     //bytes ever allocated
+	    u64 live;
+	    u64 peak;          //highest live
+	    u32 allocs;
+	    u32 frees;
+	};
+	struct ArenaStat{
+	    u64 allocated;     //bytes bumped, rounded up to 8
+	    u32 allocs;
+	};
+	struct Site{
+	    const char *file;
+	    u32 line;
+	    Stat stat;
+	    ArenaStat arena;
+	};
+	struct Tag{
+	    u16 site;
+	    u16 phase;
+	    u32 size;
+	};
+	Site sites[MAX_PROF_SITES];
+	u32 siteCount = 0;
+	const char *phaseNames[MAX_PROF_PHASES] = {"init"};
+	Stat phases[MAX_PROF_PHASES];
+	u32 phaseCount = 1;
+	u16 curPhase = 0;
+	Stat total;
+	ArenaStat arenaPhases[MAX_PROF_PHASES];
+	ArenaStat arenaTotal;
+
+	u16 getSite(const char *file, u32 line){
+	    u32 hash = (u32)(((u64)file >> 3) * 31 + line) % MAX_PROF_SITES;
+	    while(sites[hash].file){
+		if(sites[hash].file == file && sites[hash].line == line){return hash;};
+		hash = (hash + 1) % MAX_PROF_SITES;
+	    };
+	    if(siteCount == MAX_PROF_SITES - 1){return hash;};     //table full, charge to an unnamed site
+	    siteCount += 1;
+	    sites[hash].file = file;
+	    sites[hash].line = line;
+	    return hash;
+	};
+	inline void charge(Stat &stat, u32 size){
+	    stat.allocated += size;
+	    stat.live += size;
+	    stat.allocs += 1;
+	    if(stat.live > stat.peak){stat.peak = stat.live;};
+	};
+	inline void discharge(Stat &stat, u32 size){
+	    stat.live -= size;
+	    stat.frees += 1;
+	};
+	void onAlloc(Tag &tag, u32 size, const char *file, u32 line){
+	    tag.site = getSite(file, line);
+	    tag.phase = curPhase;
+	    tag.size = size;
+	    charge(sites[tag.site].stat, size);
+	    charge(phases[curPhase], size);
+	    charge(total, size);
+	};
+	void onResize(Tag &tag, u32 size){
+	    u32 grow = size - tag.size;
+	    tag.size = size;
+	    sites[tag.site].stat.allocs -= 1;
+	    phases[tag.phase].allocs -= 1;
+	    total.allocs -= 1;
+	    charge(sites[tag.site].stat, grow);
+	    charge(phases[tag.phase], grow);
+	    charge(total, grow);
+	};
+	void onFree(Tag &tag){
+	    discharge(sites[tag.site].stat, tag.size);
+	    discharge(phases[tag.phase], tag.size);
+	    discharge(total, tag.size);
+	};
+	inline void chargeArena(ArenaStat &stat, u64 size){
+	    stat.allocated += size;
+	    stat.allocs += 1;
+	};
+	void onArenaAlloc(u64 size, const char *file, u32 line){
+	    chargeArena(sites[getSite(file, line)].arena, size);
+	    chargeArena(arenaPhases[curPhase], size);
+	    chargeArena(arenaTotal, size);
+	};
+	//in place growth of the latest allocation. The call site is not known here
+	void onArenaExtend(u64 grow){
+	    arenaPhases[curPhase].allocated += grow;
+	    arenaTotal.allocated += grow;
+	};
+	void setPhase(const char *name){
+	    for(u32 x=0; x<phaseCount; x+=1){
+		if(strcmp(phaseNames[x], name) == 0){
+		    curPhase = x;
+		    return;
+		};
+	    };
+	    if(phaseCount == MAX_PROF_PHASES){return;};
+	    phaseNames[phaseCount] = name;
+	    curPhase = phaseCount;
+	    phaseCount += 1;
+	};
+	inline void dumpStat(const char *name, Stat &stat){
+	    printf("  %-24s %10u %10u %14llu %12llu %12llu\n", name, stat.allocs, stat.frees, stat.allocated, stat.live, stat.peak);
+	};
+	inline void dumpArenaStat(const char *name, ArenaStat &stat){
+	    printf("  %-24s %10u %14llu\n", name, stat.allocs, stat.allocated);
+	};
+	s32 cmpSite(const void *a, const void *b){
+	    const Site *x = &sites[*(const u16*)a];
+	    const Site *y = &sites[*(const u16*)b];
+	    if(x->stat.allocated == y->stat.allocated){return 0;};
+	    return (x->stat.allocated < y->stat.allocated)?1:-1;
+	};
+	s32 cmpArenaSite(const void *a, const void *b){
+	    const Site *x = &sites[*(const u16*)a];
+	    const Site *y = &sites[*(const u16*)b];
+	    if(x->arena.allocated == y->arena.allocated){return 0;};
+	    return (x->arena.allocated < y->arena.allocated)?1:-1;
+	};
+	void siteName(Site &site, char *name, u32 size){
+	    const char *file = (site.file)?site.file:"<other>";
+	    const char *slash = strrchr(file, '/');
+	    if(slash){file = slash + 1;};
+	    snprintf(name, size, "%s:%u", file, site.line);
+	};
+	void dumpHeap(allocator::Pool &pool){
+	    //small class chunks stay marked in stat while they sit in a free list
+	    u64 cached = 0;
+	    for(u32 x=1; x<=SMALL_CLASS_COUNT; x+=1){
+		for(u32 off=pool.freeList[x]; off!=NO_CHUNK; off=*(u32*)(pool.memory+(off*CHUNK_SIZE)+sizeof(u32))){
+		    cached += x;
+		};
+	    };
+	    u64 used = 0;
+	    for(u32 x=0; x<(pool.top+63)/64; x+=1){used += popcount64(pool.stat[x]);};
+	    u64 holeChunks = 0;
+	    u32 holes = 0;
+	    u32 largestHole = 0;
+	    u32 off = allocator::find(pool.stat, 0, pool.top, false);
+	    while(off < pool.top){
+		u32 end = allocator::find(pool.stat, off, pool.top, true);
+		holes += 1;
+		holeChunks += end - off;
+		if(end - off > largestHole){largestHole = end - off;};
+		off = allocator::find(pool.stat, end, pool.top, false);
+	    };
+	    u64 freeChunks = holeChunks + cached;
+	    f64 frag = (freeChunks == 0)?0:100.0 * (1.0 - (f64)largestHole/(f64)freeChunks);
+	    printf("  heap %u: top %u chunks(%llu KB committed), in use %llu, class cached %llu, %u holes(%llu chunks, largest %u), fragmentation %.1f%%\n",
+		   pool.heapId, pool.top, ((u64)pool.committed*CHUNK_SIZE)/1024, used - cached, cached, holes, holeChunks, largestHole, frag);
+	};
+	void dump(allocator::Pool *heaps, u32 heapCount){
+	    printf("\n[MEM_PROF] %-22s %10s %10s %14s %12s %12s\n", "phase", "allocs", "frees", "allocated(B)", "live(B)", "peak(B)");
+	    for(u32 x=0; x<phaseCount; x+=1){dumpStat(phaseNames[x], phases[x]);};
+	    dumpStat("total", total);
+	    printf("[MEM_PROF] %-22s %10s %10s %14s %12s %12s\n", "call site", "allocs", "frees", "allocated(B)", "live(B)", "peak(B)");
+	    u16 order[MAX_PROF_SITES];
+	    u32 count = 0;
+	    for(u32 x=0; x<MAX_PROF_SITES; x+=1){
+		if(sites[x].stat.allocs){order[count++] = x;};
+	    };
+	    qsort(order, count, sizeof(u16), cmpSite);
+	    char name[256];
+	    for(u32 x=0; x<count; x+=1){
+		siteName(sites[order[x]], name, sizeof(name));
+		dumpStat(name, sites[order[x]].stat);
+	    };
+	    printf("[MEM_PROF] %-22s %10s %14s\n", "arena phase", "allocs", "allocated(B)");
+	    for(u32 x=0; x<phaseCount; x+=1){dumpArenaStat(phaseNames[x], arenaPhases[x]);};
+	    dumpArenaStat("total", arenaTotal);
+	    printf("[MEM_PROF] %-22s %10s %14s\n", "arena call site", "allocs", "allocated(B)");
+	    count = 0;
+	    for(u32 x=0; x<MAX_PROF_SITES; x+=1){
+		if(sites[x].arena.allocs){order[count++] = x;};
+	    };
+	    qsort(order, count, sizeof(u16), cmpArenaSite);
+	    for(u32 x=0; x<count; x+=1){
+		siteName(sites[order[x]], name, sizeof(name));
+		dumpArenaStat(name, sites[order[x]].arena);
+	    };
+	    printf("[MEM_PROF] chunks(%d bytes each)\n", (s32)CHUNK_SIZE);
+	    for(u32 x=0; x<heapCount; x+=1){
+		if(heaps[x].memory){dumpHeap(heaps[x]);};
+	    };
+	};
+    };
+#endif
+    //names the phase that following allocations are charged to(MEM_PROF builds)
+    inline void phase(const char *name){
+#if(MEM_PROF)
+	prof::setPhase(name);
+#endif
+    };
     
-    void init(){
+    allocator::Pool *ownHeap(u32 id){
+	heapOwner.heap = &heaps[id];
+	return &heaps[id];
+    };
+    allocator::Pool *newHeap(){
+	//an orphaned heap comes with its memory already reserved
+	for(u32 x=0; x<MAX_HEAPS; x+=1){
+	    u32 state = HEAP_ORPHANED;
+	    if(heapStates[x].compare_exchange_strong(state, HEAP_OWNED, std::memory_order_acquire)){return ownHeap(x);};
+	};
+	u32 id = 0;
+	while(true){
+	    if(id == MAX_HEAPS){
 #if(DBG)
-	allocCount = 0;
+		printf("\n[MEM]: out of heaps. Please increase MAX_HEAPS\n");
 #endif
-	memory = (char*)malloc(CHUNK_SIZE   * CHUNK_COUNT);
-	const u64 statSize = sizeof(bool) * (CHUNK_COUNT + 1);   //NOTE: +1 for padding
-	stat   = (bool*)malloc(statSize);
-	memset(stat, false, statSize);
-	stat[CHUNK_COUNT] = true;
+		return nullptr;
+	    };
+	    u32 state = HEAP_FREE;
+	    if(heapStates[id].compare_exchange_strong(state, HEAP_SETUP, std::memory_order_acquire)){break;};
+	    id += 1;
+	};
+#if(HUGE_PAGES)
+	char *memory = allocator::reserveHuge(POOL_SIZE);
+	if(memory == nullptr){
 #if(DBG)
-	memset(memory, 'A', CHUNK_SIZE * CHUNK_COUNT);
+	    printf("\n[MEM]: huge pages not available, falling back to normal pages\n");
+#endif
+	    memory = allocator::reserve(POOL_SIZE);
+	};
+#else
+	char *memory = allocator::reserve(POOL_SIZE);
 #endif
+	//NOTE: has atleast 1 bit of padding. Comes zeroed, so nothing to memset
+	u64 *stat = (u64*)allocator::reserve(sizeof(u64) * STAT_WORDS);
+	if(memory == nullptr || stat == nullptr){
+	    if(memory){allocator::release(memory, POOL_SIZE);};
+	    if(stat){allocator::release((char*)stat, sizeof(u64) * STAT_WORDS);};
+	    heapStates[id].store(HEAP_FREE, std::memory_order_release);
+	    return nullptr;
+	};
+	allocator::commit((char*)stat, sizeof(u64) * STAT_WORDS);
+	allocator::mark(stat, CHUNK_COUNT, 1, true);
+	allocator::init(heaps[id], memory, stat, id);
+	heapStates[id].store(HEAP_OWNED, std::memory_order_release);
+	return ownHeap(id);
+    };
+    void init(){
+#if(DBG)
+	allocCount = 0;
+#endif
+	localHeap = newHeap();
     };
+    //NOTE: every other thread that allocated must have exited
     void uninit(){
-	::free(memory);
-	::free(stat);
+#if(MEM_PROF)
+	prof::dump(heaps, MAX_HEAPS);
+#endif
+	for(u32 x=0; x<MAX_HEAPS; x+=1){
+	    if(heaps[x].memory == nullptr){continue;};
+	    allocator::release(heaps[x].memory, POOL_SIZE);
+	    allocator::release((char*)heaps[x].stat, sizeof(u64) * STAT_WORDS);
+	    heaps[x].memory = nullptr;
+	    heaps[x].stat = nullptr;
+	    heapStates[x].store(HEAP_FREE, std::memory_order_release);
+	};
+	heapOwner.heap = nullptr;
+	localHeap = nullptr;
     };
-    void *alloc(u64 size){
+    void *alloc(u64 size MEM_SITE_PARAMS){
 #if(DBG)
 	allocCount += 1;
 #endif
-	return allocator::alloc(size, memory, stat);
+	if(localHeap == nullptr){
+	    localHeap = newHeap();
+	    if(localHeap == nullptr){return nullptr;};
+	};
+#if(MEM_PROF)
+	prof::Tag *tag = (prof::Tag*)allocator::alloc(size + sizeof(prof::Tag), *localHeap);
+	if(tag == nullptr){return nullptr;};
+	prof::onAlloc(*tag, (u32)size, file, line);
+	return tag + 1;
+#else
+	return allocator::alloc(size, *localHeap);
+#endif
     };
-    void *calloc(u64 size){
-	void *ptr = alloc(size);
+    void *calloc(u64 size MEM_SITE_PARAMS){
+	void *ptr = alloc(size MEM_SITE_ARGS);
 	memset(ptr, 0, size);
 	return ptr;
     };
@@ -102,6 +672,158 @@ namespace mem{
 	};
 	allocCount -= 1;
 #endif
-	return allocator::free(ptr, memory, stat);
+#if(MEM_PROF)
+	prof::Tag *tag = (prof::Tag*)ptr - 1;
+	prof::onFree(*tag);
+	ptr = tag;
+#endif
+	u32 header = *((u32*)ptr - 1);
+	allocator::Pool &owner = heaps[allocator::heapOf(header)];
+	if(&owner == localHeap){return allocator::free(ptr, owner);};
+	allocator::freeRemote(ptr, owner);
+    };
+    //grows an allocation to size bytes without moving it. Returns false when it has to move
+    bool tryExtend(void *ptr, u64 size){
+#if(MEM_PROF)
+	prof::Tag *tag = (prof::Tag*)ptr - 1;
+	ptr = tag;
+	size += sizeof(prof::Tag);
+#endif
+	u32 header = *((u32*)ptr - 1);
+	allocator::Pool &owner = heaps[allocator::heapOf(header)];
+	if(&owner != localHeap){return false;};
+	if(!allocator::tryExtend(ptr, allocator::chunksFor(size), owner)){return false;};
+#if(MEM_PROF)
+	if(size - sizeof(prof::Tag) > tag->size){prof::onResize(*tag, (u32)(size - sizeof(prof::Tag)));};
+#endif
+	return true;
+    };
+    /*
+      Arena for allocations that die together(a phase, a file, ...).
+      Allocation is a pointer bump, freeing individual allocations is a no-op
+      and the whole arena is thrown away with reset or uninit.
+      An arena belongs to the thread that uses it
+    */
+    struct ArenaBlock{
+	ArenaBlock *next;
+	u64 size;                  //usable bytes after the header
+    };
+    struct ArenaMark{
+	ArenaBlock *block;
+	u64 watermark;
+    };
+    struct Arena{
+	ArenaBlock *first;
+	ArenaBlock *cur;
+	u64 watermark;
+	u64 blockSize;
+
+	void init(u64 bSize=65536){
+	    first = nullptr;
+	    cur = nullptr;
+	    watermark = 0;
+	    blockSize = bSize;
+	};
+	//bulk release
+	void uninit(){
+	    ArenaBlock *block = first;
+	    while(block){
+		ArenaBlock *next = block->next;
+		mem::free(block);
+		block = next;
+	    };
+	    first = nullptr;
+	    cur = nullptr;
+	    watermark = 0;
+	};
+	inline char *blockMem(ArenaBlock *block){return (char*)(block+1);};
+	void *alloc(u64 size MEM_SITE_PARAMS){
+	    size = (size + 7) & ~(u64)7;
+#if(MEM_PROF)
+	    prof::onArenaAlloc(size, file, line);
+#endif
+	    if(cur == nullptr || watermark+size > cur->size){
+		//reuse the blocks left behind by a reset before asking for a new one
+		ArenaBlock *next = (cur)?cur->next:first;
+		if(next == nullptr || next->size < size){
+		    u64 bSize = (size > blockSize)?size:blockSize;
+		    //NOTE: blocks are charged here, the caller is charged for the bump
+		    ArenaBlock *block = (ArenaBlock*)mem::alloc(sizeof(ArenaBlock) + bSize);
+		    if(block == nullptr){return nullptr;};
+		    block->size = bSize;
+		    block->next = next;
+		    if(cur){cur->next = block;}
+		    else{first = block;};
+		    next = block;
+		};
+		cur = next;
+		watermark = 0;
+	    };
+#if(MEM_COUNT)
+	    localHeap->allocs += 1;
+#endif
+	    void *ptr = blockMem(cur) + watermark;
+	    watermark += size;
+	    return ptr;
+	};
+	//only the latest allocation can grow in place
+	bool tryExtend(void *ptr, u64 oldSize, u64 newSize){
+	    oldSize = (oldSize + 7) & ~(u64)7;
+	    newSize = (newSize + 7) & ~(u64)7;
+	    if(cur == nullptr || (char*)ptr + oldSize != blockMem(cur) + watermark){return false;};
+	    u64 newWatermark = watermark - oldSize + newSize;
+	    if(newWatermark > cur->size){
+		//a block that holds only this allocation can grow along with it
+		if((char*)ptr != blockMem(cur)){return false;};
+		if(!mem::tryExtend(cur, sizeof(ArenaBlock) + newSize)){return false;};
+		cur->size = newSize;
+	    };
+#if(MEM_PROF)
+	    prof::onArenaExtend(newWatermark - watermark);
+#endif
+	    watermark = newWatermark;
+	    return true;
+	};
+	ArenaMark mark(){return {cur, watermark};};
+	//everything allocated after the mark is dropped. Blocks are kept for reuse
+	void reset(ArenaMark m){
+#if(DBG)
+	    ArenaBlock *block = (m.block)?m.block:first;
+	    u64 off = (m.block)?m.watermark:0;
+	    while(block){
+		memset(blockMem(block)+off, 'A', ((block == cur)?watermark:block->size) - off);
+		if(block == cur){break;};
+		block = block->next;
+		off = 0;
+	    };
+#endif
+	    cur = m.block;
+	    watermark = m.watermark;
+	};
+	void reset(){reset({nullptr, 0});};
+	//like reset, but the blocks after the mark go back to the pool
+	void release(ArenaMark m){
+	    reset(m);
+	    ArenaBlock *block = (cur)?cur->next:first;
+	    if(cur){cur->next = nullptr;}
+	    else{first = nullptr;};
+	    while(block){
+		ArenaBlock *next = block->next;
+		mem::free(block);
+		block = next;
+	    };
+	};
+    };
+    void *alloc(u64 size, Arena *arena MEM_SITE_PARAMS){
+	if(arena){return arena->alloc(size MEM_SITE_ARGS);};
+	return alloc(size MEM_SITE_ARGS);
+    };
+    void free(void *ptr, Arena *arena){
+	if(arena){return;};
+	free(ptr);
+    };
+    bool tryExtend(void *ptr, u64 oldSize, u64 newSize, Arena *arena){
+	if(arena){return arena->tryExtend(ptr, oldSize, newSize);};
+	return tryExtend(ptr, newSize);
     };
 };
\ No newline at end of file
@@ -1,5 +1,5 @@
-#define AST_PAGE_SIZE 1024
-#define BRING_TOKENS_TO_SCOPE DynamicArray<TokType> &tokTypes = lexer.tokenTypes;DynamicArray<TokenOffset> &tokOffs = lexer.tokenOffsets;
+#define AST_PAGE_SIZE 65536
+#define BRING_TOKENS_TO_SCOPE DynamicArray<TokType> &tokTypes = lexer.tokenTypes;DynamicArray<u32> &tokOffs = lexer.tokenOffsets;
 
 enum class ASTType{
     INVALID,
@@ -94,6 +94,7 @@ struct ASTFor : ASTBase{
         ASTBase *step;
     };
     String iter;
+    u32 iterSym;
     ASTTypeNode *type;
     ASTBase *initializer;
     ASTBase *end;
@@ -103,6 +104,7 @@ struct ASTFor : ASTBase{
 };
 struct ASTProcDefDecl : ASTBase{
     String name;
+    u32 sym;
     ASTAssDecl  **inputs;
     ASTTypeNode **outputs;
     ASTBase     **body;
@@ -113,12 +115,14 @@ struct ASTProcDefDecl : ASTBase{
 };
 struct ASTStruct : ASTBase{
     String name;
+    u32 sym;
     ASTBase **body;
     u32 bodyCount;
     u32 tokenOff;
 };
 struct ASTVariable : ASTBase{
     String name;
+    u32 sym;
     union{
         u32 tokenOff;
         VariableEntity *entity;
@@ -127,6 +131,7 @@ struct ASTVariable : ASTBase{
 };
 struct ASTModifier : ASTBase{
     String name;
+    u32 sym;
     ASTBase *child;
     union{
         u32 tokenOff;
@@ -136,6 +141,7 @@ struct ASTModifier : ASTBase{
 };
 struct ASTProcCall : ASTBase{
     String name;
+    u32 sym;
     ASTBase **args;
     u32 argCount;
     u32 tokenOff;
@@ -153,44 +159,32 @@ struct ASTString : ASTBase{
     String str;
 };
 
+static mem::Arena astArena;    //AST nodes of every file. Released LIFO as files get lowered
+
 struct ASTFile{
-    DynamicArray<char*>    pages;
     DynamicArray<ASTBase*> nodes;
     DynamicArray<u32>      dependencies;
-    u32 curPageWatermark;
+    mem::ArenaMark         astMark;
 
     void init(){
+        astMark = astArena.mark();
         dependencies.init();
-        pages.init();
         nodes.init();
-        pages.push((char*)mem::alloc(AST_PAGE_SIZE));
-        curPageWatermark = 0;
     };
+    //NOTE: drops the nodes of every file parsed after this one as well
     void uninit(){
+        astArena.release(astMark);
         dependencies.uninit();
-        for(u32 x=0; x<pages.count; x++) mem::free(pages[x]);
-        pages.uninit();
         nodes.uninit();
     };
     ASTBase* newNode(u64 size, ASTType type){
-        if(curPageWatermark+size >= AST_PAGE_SIZE){
-            pages.push((char*)mem::alloc(AST_PAGE_SIZE));
-            curPageWatermark = 0;
-        };
-        ASTBase *node = (ASTBase*)(pages[pages.count-1] + curPageWatermark);
-        curPageWatermark += size;
+        ASTBase *node = (ASTBase*)astArena.alloc(size);
         node->type = type;
         return node;
     };
     //bump-allocator for AST node members
     void* balloc(u64 size){
-        if(curPageWatermark+size >= AST_PAGE_SIZE){
-            pages.push((char*)mem::alloc(AST_PAGE_SIZE));
-            curPageWatermark = 0;
-        };
-        char *mem = pages[pages.count-1] + curPageWatermark;
-        curPageWatermark += size;
-        return mem;
+        return astArena.alloc(size);
     };
 };
 
@@ -241,13 +235,16 @@ f64 string2float(const String &str){
     return (f64)num/pow(10, str.len-decimal-1-postDecimalBadChar);
 };
 String makeStringFromTokOff(u32 x, Lexer &lexer){
-    BRING_TOKENS_TO_SCOPE;
-    TokenOffset off = tokOffs[x];
     String str;
-    str.len = off.len;
-    str.mem = lexer.fileContent + off.off;
+    str.len = lexer.tokenLen(x);
+    str.mem = lexer.fileContent + lexer.tokenOffsets[x];
     return str;
 };
+//symbol id of an identifier token, 0 if it is not one
+u32 getSymbol(u32 x, Lexer &lexer){
+    if(lexer.tokenTypes[x] != TokType::IDENTIFIER) return 0;
+    return lexer.tokenValue(x);
+};
 u32 getOperatorPriority(ASTType op){
     switch(op){
         case ASTType::B_ADD:
@@ -264,7 +261,7 @@ ASTBase *genVariable(Lexer &lexer, ASTFile &file, u32 &xArg){
     u32 x = xArg;
     DEFER(xArg = x-1);
     if(tokTypes[x] != TokType::IDENTIFIER){
-        lexer.emitErr(tokOffs[x].off, "Expected an identifier");
+        lexer.emitErr(tokOffs[x], "Expected an identifier");
         return nullptr;
     };
     ASTBase *root = nullptr;
@@ -280,7 +277,8 @@ ASTBase *genVariable(Lexer &lexer, ASTFile &file, u32 &xArg){
         };
         if(tokTypes[x] == (TokType)'.'){
             ASTModifier *mod = (ASTModifier*)file.newNode(sizeof(ASTModifier), ASTType::MODIFIER);
-            mod->name = makeStringFromTokOff(start, lexer);
+            mod->sym = getSymbol(start, lexer);
+            mod->name = Symbol::name(mod->sym);
             mod->tokenOff = start;
             mod->pAccessDepth = pointerDepth;
             childReq = true;
@@ -290,7 +288,8 @@ ASTBase *genVariable(Lexer &lexer, ASTFile &file, u32 &xArg){
             x += 1;
         }else{
             ASTVariable *var = (ASTVariable*)file.newNode(sizeof(ASTVariable), ASTType::VARIABLE);
-            var->name = makeStringFromTokOff(start, lexer);
+            var->sym = getSymbol(start, lexer);
+            var->name = Symbol::name(var->sym);
             var->tokenOff = start;
             var->pAccessDepth = pointerDepth;
             childReq = false;
@@ -308,9 +307,10 @@ ASTBase *genVariable(Lexer &lexer, ASTFile &file, u32 &xArg){
             }else if(childWriteLoc) *childWriteLoc = var;
             if(root == nullptr){root = var;};
         };
+        if(lexer.startsLine(x)) break;
     };
     if(childReq){
-        lexer.emitErr(tokOffs[x].off, "Identifier required");
+        lexer.emitErr(tokOffs[x], "Identifier required");
         return nullptr;
     };
     return root;
@@ -325,7 +325,7 @@ ASTTypeNode* genASTTypeNode(Lexer &lexer, ASTFile &file, u32 &xArg){
         x++;
     };
     if(isType(tokTypes[x]) == false && tokTypes[x] != TokType::IDENTIFIER){
-        lexer.emitErr(tokOffs[x].off, "Expected a type");
+        lexer.emitErr(tokOffs[x], "Expected a type");
         return nullptr;
     };
     ASTTypeNode *type = (ASTTypeNode*)file.newNode(sizeof(ASTTypeNode), ASTType::TYPE);
@@ -390,12 +390,13 @@ ASTBase* _genASTExprTree(Lexer &lexer, ASTFile &file, u32 &xArg, u8 &bracketArg)
             lhs = num;
         }break;
         case TokType::IDENTIFIER:{
-            if(tokTypes[x+1] == (TokType)'('){
+            if(tokTypes[x+1] == (TokType)'(' && !lexer.startsLine(x+1)){
                 ASTProcCall *pcall = (ASTProcCall*)file.newNode(sizeof(ASTProcCall), ASTType::PROC_CALL);
                 pcall->tokenOff = x;
-                pcall->name = makeStringFromTokOff(x, lexer);
+                pcall->sym = getSymbol(x, lexer);
+                pcall->name = Symbol::name(pcall->sym);
                 x += 2;
-                DynamicArray<ASTBase*> args;
+                SmallArray<ASTBase*, 8> args;
                 args.init();
                 while(true){
                     ASTBase *arg = genASTExprTree(lexer, file, x);
@@ -406,12 +407,11 @@ ASTBase* _genASTExprTree(Lexer &lexer, ASTFile &file, u32 &xArg, u8 &bracketArg)
                     args.push(arg);
                     if(tokTypes[x] == (TokType)')') break;
                     if(tokTypes[x] != (TokType)','){
-                        lexer.emitErr(tokOffs[x].off, "Expected ')' or ','");
+                        lexer.emitErr(tokOffs[x], "Expected ')' or ','");
                         return nullptr;
                     };
                     x++;
                 };
-                x++;
                 u32 size = sizeof(ASTBase*)*args.count;
                 ASTBase **argNodes = (ASTBase**)file.balloc(size);
                 memcpy(argNodes, args.mem, size);
@@ -425,7 +425,7 @@ ASTBase* _genASTExprTree(Lexer &lexer, ASTFile &file, u32 &xArg, u8 &bracketArg)
             }
         }break;
         default:{
-            lexer.emitErr(tokOffs[x].off, "Invalid operand");
+            lexer.emitErr(tokOffs[x], "Invalid operand");
             return nullptr;
         }break;
     };
@@ -434,6 +434,8 @@ ASTBase* _genASTExprTree(Lexer &lexer, ASTFile &file, u32 &xArg, u8 &bracketArg)
         lhs = unOp;
     };
     x++;
+    //the expression ends with the line
+    if(lexer.startsLine(x)) return lhs;
     //closing bracket ')'
     if(tokTypes[x] == (TokType)')'){
         hasBracket=false;
@@ -449,7 +451,6 @@ ASTBase* _genASTExprTree(Lexer &lexer, ASTFile &file, u32 &xArg, u8 &bracketArg)
         case TokType::END_OF_FILE:
         case TokType::TDOT:
         case TokType::DDOT:
-        case (TokType)'\n':
         case (TokType)'{':
         case (TokType)']':
         case (TokType)',': return lhs;
@@ -477,7 +478,7 @@ ASTBase* _genASTExprTree(Lexer &lexer, ASTFile &file, u32 &xArg, u8 &bracketArg)
             }else type = ASTType::B_LSR;
         }break;
         default:{
-            lexer.emitErr(tokOffs[x].off, "Invalid operator");
+            lexer.emitErr(tokOffs[x], "Invalid operator");
             return nullptr;
         }break;
     };
@@ -485,6 +486,10 @@ ASTBase* _genASTExprTree(Lexer &lexer, ASTFile &file, u32 &xArg, u8 &bracketArg)
     binOp->tokenOff = x;
     binOp->hasBracket = hasBracket;
     x++;
+    if(lexer.startsLine(x)){
+        lexer.emitErr(tokOffs[x-1] + lexer.tokenLen(x-1), "Invalid operand");
+        return nullptr;
+    };
     //build rest of expression
     ASTBase *rhs = _genASTExprTree(lexer, file, x, bracket);
     if(!rhs){return nullptr;};
@@ -513,7 +518,7 @@ ASTBase* genASTExprTree(Lexer &lexer, ASTFile &file, u32 &xArg){
             u32 x = xArg;
             DEFER(xArg = x);
             x++;
-            DynamicArray<ASTBase*> elements;
+            SmallArray<ASTBase*, 8> elements;
             elements.init();
             while(true){
                 ASTBase *node = genASTExprTree(lexer, file, x);
@@ -524,7 +529,7 @@ ASTBase* genASTExprTree(Lexer &lexer, ASTFile &file, u32 &xArg){
                 elements.push(node);
                 if(tokTypes[x] == (TokType)'}') break;
                 if(tokTypes[x] != (TokType)','){
-                    lexer.emitErr(tokOffs[x].off, "Expected ','");
+                    lexer.emitErr(tokOffs[x], "Expected ','");
                     elements.uninit();
                     return nullptr;
                 };
@@ -548,24 +553,22 @@ ASTBase* genASTExprTree(Lexer &lexer, ASTFile &file, u32 &xArg){
         }break;
         case TokType::SINGLE_QUOTES:{
             ASTNum *character = (ASTNum*)file.newNode(sizeof(ASTNum), ASTType::CHARACTER);
-            character->character = (char)lexer.fileContent[tokOffs[xArg].off];
+            character->character = (char)lexer.fileContent[tokOffs[xArg]];
             xArg++;
             return character;
         }break;
     };
     ASTBase *tree = _genASTExprTree(lexer, file, xArg, bracket);
     if(bracket != 0){
-        lexer.emitErr(tokOffs[start].off, "Expected %d closing bracket%sin this expression", bracket, (bracket==1)?" ":"s ");
+        lexer.emitErr(tokOffs[start], "Expected %d closing bracket%sin this expression", bracket, (bracket==1)?" ":"s ");
         return nullptr;
     };
     return tree;
 };
 
-inline u32 eatNewLine(DynamicArray<TokType> &types, u32 x){
-    while(types[x] == (TokType)'\n') x++;
-    return x;
-};
-bool parseBlock(Lexer &lexer, ASTFile &file, DynamicArray<ASTBase*> &table, u32 &xArg);
+//table is a DynamicArray or a SmallArray of ASTBase*, parseBlock only pushes to it
+template<typename Table>
+bool parseBlock(Lexer &lexer, ASTFile &file, Table &table, u32 &xArg);
 ASTBase** parseBody(Lexer &lexer, ASTFile &file, u32 &xArg, u32 &count){
     BRING_TOKENS_TO_SCOPE;
     u32 x = xArg;
@@ -573,8 +576,7 @@ ASTBase** parseBody(Lexer &lexer, ASTFile &file, u32 &xArg, u32 &count){
     if(tokTypes[x] == (TokType)'{'){
         u32 start = x;
         x++;
-        x = eatNewLine(lexer.tokenTypes, x);
-        DynamicArray<ASTBase*> bodyTable;
+        SmallArray<ASTBase*, 16> bodyTable;
         bodyTable.init();
         while(tokTypes[x] != (TokType)'}'){
             if(!parseBlock(lexer, file, bodyTable, x)){
@@ -582,7 +584,7 @@ ASTBase** parseBody(Lexer &lexer, ASTFile &file, u32 &xArg, u32 &count){
                 return nullptr;
             };
             if(tokTypes[x] == TokType::END_OF_FILE){
-                lexer.emitErr(tokOffs[start].off, "Expected closing '}'");
+                lexer.emitErr(tokOffs[start], "Expected closing '}'");
                 return nullptr;
             };
         };
@@ -595,16 +597,19 @@ ASTBase** parseBody(Lexer &lexer, ASTFile &file, u32 &xArg, u32 &count){
         return bodyNodes;
     }else if(tokTypes[x] == (TokType)':'){
         x++;
-        DynamicArray<ASTBase*> bodyTable;
-        bodyTable.init(1);
-        if(!parseBlock(lexer, file, bodyTable, x)) return nullptr;
+        SmallArray<ASTBase*, 1> bodyTable;
+        bodyTable.init();
+        if(!parseBlock(lexer, file, bodyTable, x)){
+            bodyTable.uninit();
+            return nullptr;
+        };
         ASTBase **bodyNode = (ASTBase**)file.balloc(sizeof(ASTBase*));
         *bodyNode = bodyTable[0];
         bodyTable.uninit();
         count = 1;
         return bodyNode;
     }else{
-        lexer.emitErr(tokOffs[x].off, "Expected '{' or ':'");
+        lexer.emitErr(tokOffs[x], "Expected '{' or ':'");
         return nullptr;
     };
 };
@@ -613,7 +618,7 @@ ASTAssDecl* parseAssDecl(Lexer &lexer, ASTFile &file, u32 &xArg){
     u32 x = xArg;
     u32 start = x;
     DEFER(xArg = x);
-    DynamicArray<ASTBase*> lhs;
+    SmallArray<ASTBase*, 4> lhs;
     lhs.init();
     ASTBase *var = genVariable(lexer, file, x);
     if(!var){
@@ -625,7 +630,7 @@ ASTAssDecl* parseAssDecl(Lexer &lexer, ASTFile &file, u32 &xArg){
     x++;
     while(tokTypes[x] != (TokType)':' && tokTypes[x] != (TokType)'='){
         if(tokTypes[x] != (TokType)','){
-            lexer.emitErr(tokOffs[x].off, "Expected ',' or ':'");
+            lexer.emitErr(tokOffs[x], "Expected ',' or ':'");
             return nullptr;
         };
         x++;
@@ -651,7 +656,7 @@ ASTAssDecl* parseAssDecl(Lexer &lexer, ASTFile &file, u32 &xArg){
         if(tokTypes[x] != (TokType)'='){
             ASTTypeNode *type = genASTTypeNode(lexer, file, x);
             assdecl->zType = type;
-            if(tokTypes[x] != (TokType)'='){
+            if(tokTypes[x] != (TokType)'=' || lexer.startsLine(x)){
                 assdecl->rhs = nullptr;
                 return assdecl;
             };
@@ -664,32 +669,29 @@ ASTAssDecl* parseAssDecl(Lexer &lexer, ASTFile &file, u32 &xArg){
     assdecl->rhs = expr;
     return assdecl;
 };
-bool parseBlock(Lexer &lexer, ASTFile &file, DynamicArray<ASTBase*> &table, u32 &xArg){
+template<typename Table>
+bool parseBlock(Lexer &lexer, ASTFile &file, Table &table, u32 &xArg){
     BRING_TOKENS_TO_SCOPE;
     u32 x = xArg;
-    x = eatNewLine(tokTypes, x);
-    DEFER({
-        x = eatNewLine(tokTypes, x);
-        xArg = x;
-    });
+    DEFER(xArg = x);
     u32 start = x;
     switch(tokTypes[x]){
         case TokType::P_STACK_SIZE:{
             if(tokTypes[++x] != (TokType)'='){
-                lexer.emitErr(tokOffs[x].off, "Expected a '='");
+                lexer.emitErr(tokOffs[x], "Expected a '='");
                 return false;
             };
             if(tokTypes[++x] == TokType::INTEGER) pStackSize = (f32)string2int(makeStringFromTokOff(x, lexer));
             else if(tokTypes[x] == TokType::DECIMAL) pStackSize = (f32)string2float(makeStringFromTokOff(x, lexer));
             else{
-                lexer.emitErr(tokOffs[x].off, "Expected an integer or a decimal");
+                lexer.emitErr(tokOffs[x], "Expected an integer or a decimal");
                 return false;
             };
             x++;
         }break;
         case TokType::P_IMPORT:{
             if(tokTypes[++x] != TokType::DOUBLE_QUOTES){
-                lexer.emitErr(tokOffs[x].off, "Expected a string");
+                lexer.emitErr(tokOffs[x], "Expected a string");
                 return false;
             };
             String name = makeStringFromTokOff(x, lexer);
@@ -702,7 +704,8 @@ bool parseBlock(Lexer &lexer, ASTFile &file, DynamicArray<ASTBase*> &table, u32
             For->tokenOff = ++x;
             if(tokTypes[x+1] == (TokType)':'){
                 //c-for
-                For->iter = makeStringFromTokOff(x, lexer);
+                For->iterSym = getSymbol(x, lexer);
+                For->iter = Symbol::name(For->iterSym);
                 x += 2;
                 ASTBase *node;
                 if(tokTypes[x] != (TokType)'='){
@@ -711,7 +714,7 @@ bool parseBlock(Lexer &lexer, ASTFile &file, DynamicArray<ASTBase*> &table, u32
                     For->type = typeNode;
                 }else For->type = nullptr;
                 if(tokTypes[x] != (TokType)'='){
-                    lexer.emitErr(tokOffs[x].off, "Expected '='");
+                    lexer.emitErr(tokOffs[x], "Expected '='");
                     return false;
                 };
                 x++;
@@ -719,7 +722,7 @@ bool parseBlock(Lexer &lexer, ASTFile &file, DynamicArray<ASTBase*> &table, u32
                 if(!node) return false;
                 For->initializer = node;
                 if(tokTypes[x] != TokType::TDOT){
-                    lexer.emitErr(tokOffs[x].off, "Expected '...'");
+                    lexer.emitErr(tokOffs[x], "Expected '...'");
                     return false;
                 }
                 node = genASTExprTree(lexer, file, ++x);
@@ -755,7 +758,6 @@ bool parseBlock(Lexer &lexer, ASTFile &file, DynamicArray<ASTBase*> &table, u32
             ASTBase *expr = genASTExprTree(lexer, file, x);
             if(!expr) return false;
             If->expr = expr;
-            x = eatNewLine(lexer.tokenTypes, x);
             u32 count;
             ASTBase **bodyNodes = parseBody(lexer, file, x, count);
             if(!bodyNodes) return false;
@@ -764,7 +766,7 @@ bool parseBlock(Lexer &lexer, ASTFile &file, DynamicArray<ASTBase*> &table, u32
             if(tokTypes[x] == TokType::K_ELSE){
                 if(tokTypes[++x] == TokType::K_IF){
                     //else if
-                    DynamicArray<ASTBase*> elseIfBody;
+                    SmallArray<ASTBase*, 1> elseIfBody;
                     elseIfBody.init();
                     if(!parseBlock(lexer, file, elseIfBody, x)){
                         elseIfBody.uninit();
@@ -792,7 +794,8 @@ bool parseBlock(Lexer &lexer, ASTFile &file, DynamicArray<ASTBase*> &table, u32
                 switch(tokTypes[x]){
                     case TokType::K_STRUCT:{
                         ASTStruct *Struct = (ASTStruct*)file.newNode(sizeof(ASTStruct), ASTType::STRUCT);
-                        Struct->name = makeStringFromTokOff(start, lexer);
+                        Struct->sym = getSymbol(start, lexer);
+                        Struct->name = Symbol::name(Struct->sym);
                         Struct->tokenOff = start;
                         u32 count;
                         ASTBase **body = parseBody(lexer, file, ++x, count);
@@ -803,15 +806,16 @@ bool parseBlock(Lexer &lexer, ASTFile &file, DynamicArray<ASTBase*> &table, u32
                     }break;
                     case TokType::K_PROC:{
                         if(tokTypes[++x] != (TokType)'('){
-                            lexer.emitErr(tokOffs[x].off, "Expected '('");
+                            lexer.emitErr(tokOffs[x], "Expected '('");
                             return false;
                         };
                         ASTProcDefDecl *proc = (ASTProcDefDecl*)file.newNode(sizeof(ASTProcDefDecl), ASTType::PROC_DEF);
-                        proc->name = makeStringFromTokOff(start, lexer);
+                        proc->sym = getSymbol(start, lexer);
+                        proc->name = Symbol::name(proc->sym);
                         proc->tokenOff = start;
                         if(tokTypes[++x] == (TokType)')'){proc->inputCount = 0;}
                         else{
-                            DynamicArray<ASTAssDecl*> inputs;
+                            SmallArray<ASTAssDecl*, 8> inputs;
                             inputs.init();
                             while(true){
                                 ASTAssDecl *input = parseAssDecl(lexer, file, x);
@@ -821,7 +825,7 @@ bool parseBlock(Lexer &lexer, ASTFile &file, DynamicArray<ASTBase*> &table, u32
                                 };
                                 inputs.push(input);
                                 if(tokTypes[x] != (TokType)')' && tokTypes[x] != (TokType)','){
-                                    lexer.emitErr(tokOffs[x].off, "Expected ')' or ','");
+                                    lexer.emitErr(tokOffs[x], "Expected ')' or ','");
                                     inputs.uninit();
                                     return false;
                                 }else if(tokTypes[x] == (TokType)')') break;
@@ -836,7 +840,7 @@ bool parseBlock(Lexer &lexer, ASTFile &file, DynamicArray<ASTBase*> &table, u32
                         };
                         if(tokTypes[++x] == (TokType)'-'){
                             if(tokTypes[++x] != (TokType)'>'){
-                                lexer.emitErr(tokOffs[x].off, "Expected '>'");
+                                lexer.emitErr(tokOffs[x], "Expected '>'");
                                 return false;
                             }
                             bool bracket = false;
@@ -844,7 +848,7 @@ bool parseBlock(Lexer &lexer, ASTFile &file, DynamicArray<ASTBase*> &table, u32
                                 bracket = true;
                                 x++;
                             };
-                            DynamicArray<ASTTypeNode*> outputs;
+                            SmallArray<ASTTypeNode*, 4> outputs;
                             outputs.init();
                             while(true){
                                 ASTTypeNode *output = genASTTypeNode(lexer, file, x);
@@ -854,13 +858,13 @@ bool parseBlock(Lexer &lexer, ASTFile &file, DynamicArray<ASTBase*> &table, u32
                                 };
                                 outputs.push(output);
                                 if(tokTypes[x] != (TokType)')' && tokTypes[x] != (TokType)',' && tokTypes[x] != (TokType)'{'){
-                                    lexer.emitErr(tokOffs[x].off, "Expected ')' or ',' or '{'");
+                                    lexer.emitErr(tokOffs[x], "Expected ')' or ',' or '{'");
                                     outputs.uninit();
                                     return false;
                                 }else if(tokTypes[x] == (TokType)'{') break;
                                 else if(tokTypes[x] == (TokType)')'){
                                     if(!bracket){
-                                        lexer.emitErr(tokOffs[x].off, "No opening bracket to match this closing bracket");
+                                        lexer.emitErr(tokOffs[x], "No opening bracket to match this closing bracket");
                                         outputs.uninit();
                                         return false;
                                     }else{
@@ -879,6 +883,7 @@ bool parseBlock(Lexer &lexer, ASTFile &file, DynamicArray<ASTBase*> &table, u32
                         }else proc->outputCount = 0;
                         u32 count;
                         ASTBase **body = parseBody(lexer, file, x, count);
+                        if(!body) return false;
                         proc->body = body;
                         proc->bodyCount = count;
                         table.push(proc);
@@ -887,7 +892,7 @@ bool parseBlock(Lexer &lexer, ASTFile &file, DynamicArray<ASTBase*> &table, u32
                 return true;
             };
             bool shouldParseAssOrDecl = false;
-            while(tokTypes[x] != (TokType)'\n' && tokTypes[x] != TokType::END_OF_FILE){
+            while(!lexer.startsLine(x) && tokTypes[x] != TokType::END_OF_FILE){
                 if((tokTypes[x] == (TokType)'=' && tokTypes[x+1] != (TokType)'=') || tokTypes[x] == (TokType)':'){
                     shouldParseAssOrDecl = true;
                     break;
@@ -904,7 +909,7 @@ bool parseBlock(Lexer &lexer, ASTFile &file, DynamicArray<ASTBase*> &table, u32
             table.push(assdecl);
         }break;
         case TokType::K_ELSE:{
-            lexer.emitErr(tokOffs[x].off, "Expected 'if' before 'else'");
+            lexer.emitErr(tokOffs[x], "Expected 'if' before 'else'");
             return false;
         }break;
         default:{
@@ -918,7 +923,7 @@ bool parseBlock(Lexer &lexer, ASTFile &file, DynamicArray<ASTBase*> &table, u32
 };
 bool parseFile(Lexer &lexer, ASTFile &file){
     BRING_TOKENS_TO_SCOPE;
-    u32 cursor = eatNewLine(tokTypes, 0);
+    u32 cursor = 0;
     while(tokTypes[cursor] != TokType::END_OF_FILE){
         if(!parseBlock(lexer, file, file.nodes, cursor)) return false;
     };
@@ -17,18 +17,25 @@ struct VarInfo{
     s32 fpOff;    //offset from fp
     bool dw;      //dw or w?
 };
+static mem::Arena asmArena;       //everything of the ASMFile being lowered. Reset after every file
+
 struct Area{
-    HashmapStr varToOff;          //maps var name to offset in offs
+    GenHashmap<u32, u32> varToOff;   //maps var symbol to offset in offs
     DynamicArray<VarInfo> infos;
     
     void init(){
-        varToOff.init();
-        infos.init();
+        varToOff.init(10, &asmArena);
+        infos.init(5, &asmArena);
     }
     void uninit(){
         varToOff.uninit();
         infos.uninit();
     }
+    //keeps the tables so the next procedure can reuse them
+    void clear(){
+        varToOff.clear();
+        infos.count = 0;
+    }
 };
 struct Register : VarInfo{
     String globalName;
@@ -39,7 +46,7 @@ struct ASMBucket{
     ASMBucket *next;
 };
 struct ASMFile{
-    DynamicArray<Area> areas;
+    DynamicArray<Area> areas;  //pool. Areas past areaCount are cleared and wait to be reused
     ASMBucket *start;
     ASMBucket *cur;
     /*
@@ -57,14 +64,15 @@ struct ASMFile{
     Register regs[REGS];
     u32 fpOff;                 //off from fp
     u32 cursor;                //cursor for ASMBucket buffer
+    u32 areaCount;             //areas in use
 
     void init(){
         fpOff = 0;
         cursor = 0;
-        areas.init(10);
-        Area &fileArea = areas.newElem();
-        fileArea.init();
-        start = (ASMBucket*)mem::alloc(sizeof(ASMBucket));
+        areaCount = 0;
+        areas.init(10, &asmArena);
+        pushArea();
+        start = (ASMBucket*)asmArena.alloc(sizeof(ASMBucket));
         start->buff[BUCKET_BUFFER_SIZE] = '\0';
         start->next = nullptr;
         cur = start;
@@ -74,6 +82,13 @@ struct ASMFile{
         for(u32 x=0; x<areas.count; x++) areas[x].uninit();
         areas.uninit();
     };
+    Area &pushArea(){
+        if(areaCount == areas.count) areas.newElem().init();
+        return areas[areaCount++];
+    };
+    void popArea(){
+        areas[--areaCount].clear();
+    };
     void write(char *fmt, ...){
         va_list args;
         va_start(args, fmt);
@@ -81,7 +96,7 @@ struct ASMFile{
         va_end(args);
         if(res + cursor + 1 >= BUCKET_BUFFER_SIZE){
             cur->buff[cursor] = '\0';
-            ASMBucket *buc = (ASMBucket*)mem::alloc(sizeof(ASMBucket));
+            ASMBucket *buc = (ASMBucket*)asmArena.alloc(sizeof(ASMBucket));
             buc->buff[BUCKET_BUFFER_SIZE] = '\0';
             buc->next = nullptr;
             cursor = 0;
@@ -97,7 +112,7 @@ struct ASMFile{
     };
 };
 
-static HashmapStr globalToOff;
+static Hashmap<u32, u32> globalToOff;
 static DynamicArray<VarInfo> globalInfos;
 
 inline void store(u32 reg, ASMFile &file){
@@ -132,7 +147,7 @@ inline void setRegister(u32 reg, u32 gen, String globalName, VarInfo info, ASMFi
     regist.globalName = globalName;
 };
 u32 getOrCreateFreeRegister(ASMFile &file){
-    u32 curGen = file.areas.count;
+    u32 curGen = file.areaCount;
     for(u32 x=0; x<REGS; x++){
         if(file.regs[x].fpOff == FREE_REG) return x;
     };
@@ -145,24 +160,25 @@ u32 getOrCreateFreeRegister(ASMFile &file){
     store(0, file);
     return 0;
 };
-VarInfo getVarInfo(String &name, ASMFile &file, u32 *generation = nullptr){
-    u32 curGen = file.areas.count;
+VarInfo getVarInfo(u32 sym, ASMFile &file, u32 *generation = nullptr){
+    u32 curGen = file.areaCount;
     u32 gen = curGen;
     while(gen>0){
         u32 off;
-        if(file.areas[--gen].varToOff.getValue(name, &off)){
+        if(file.areas[--gen].varToOff.getValue(sym, &off)){
             if(generation) *generation = gen;
             return file.areas[gen].infos[off];
         };
     };
     if(generation) *generation = 0;
     u32 off;
-    globalToOff.getValue(name, &off);
+    globalToOff.getValue(sym, &off);
     return globalInfos[off];
 };
-u32 getOrLoadToRegister(String &name, ASMFile &file, bool loadOnlyAddress = false){
+u32 getOrLoadToRegister(u32 sym, ASMFile &file, bool loadOnlyAddress = false){
     u32 gen;
-    VarInfo info = getVarInfo(name, file, &gen);
+    VarInfo info = getVarInfo(sym, file, &gen);
+    String name = Symbol::name(sym);
     for(u32 x=0; x<REGS; x++){
         if(file.regs[x].gen == gen && file.regs[x].fpOff == info.fpOff) return x;
     };
@@ -183,7 +199,7 @@ u32 lowerExpression(ASTBase *node, ASMFile &file){
             switch(node->type){
                 case ASTType::VARIABLE:{
                     ASTVariable *var = (ASTVariable*)node;
-                    VarInfo info = getVarInfo(var->name, file);
+                    VarInfo info = getVarInfo(var->sym, file);
                     u32 reg = getOrCreateFreeRegister(file);
                     file.write("addi x%d, x5, %d", reg+START_FREE_REG, info.fpOff);
                     return reg;
@@ -200,13 +216,13 @@ u32 lowerExpression(ASTBase *node, ASMFile &file){
             u32 reg = getOrCreateFreeRegister(file);
             bool dw = false;
             if(num->integer > 2147483647) dw = true;
-            setRegister(reg, file.areas.count-1, {nullptr, 0}, {CONST_IN_REG, dw}, file);
+            setRegister(reg, file.areaCount-1, {nullptr, 0}, {CONST_IN_REG, dw}, file);
             file.write("li x%d, %lld", reg+START_FREE_REG, num->integer);
             return reg;
         }break;
         case ASTType::VARIABLE:{
             ASTVariable *var = (ASTVariable*)node;
-            return getOrLoadToRegister(var->name, file);
+            return getOrLoadToRegister(var->sym, file);
         }break;
         default: UNREACHABLE;
     };
@@ -266,8 +282,7 @@ void lowerASTNode(ASTBase *node, ASMFile &file){
                 stackSize = (u32)(pStackSize * 1000);
                 file.write("li x6, %d\nsub sp, sp, x6\naddi x5, sp, 0", stackSize);
             };
-            Area &procArea = file.areas.newElem();
-            procArea.init();
+            Area &procArea = file.pushArea();
             u32 procArgRegisterCount = 0;
             u32 stackAbove = 0;
             u32 stackBelow = 0;
@@ -275,7 +290,7 @@ void lowerASTNode(ASTBase *node, ASMFile &file){
                 ASTAssDecl *decl = proc->inputs[--x];
                 for(u32 i=0; i<decl->lhsCount; i++){
                     ASTVariable *var = (ASTVariable*)decl->lhs[i];
-                    procArea.varToOff.insertValue(var->name, procArea.infos.count);
+                    procArea.varToOff.insertValue(var->sym, procArea.infos.count);
                     VarInfo &info = procArea.infos.newElem();
                     if(var->entity->size > 64 || procArgRegisterCount >= PROC_ARG_REG_COUNT){
                         stackBelow += var->entity->size;
@@ -285,14 +300,14 @@ void lowerASTNode(ASTBase *node, ASMFile &file){
                         stackAbove += var->entity->size;
                         info.fpOff = stackAbove;
                         info.dw = false;
-                        setRegister(procArgRegisterCount, file.areas.count-1, {nullptr, 0}, {info.fpOff, false}, file);
+                        setRegister(procArgRegisterCount, file.areaCount-1, {nullptr, 0}, {info.fpOff, false}, file);
                         procArgRegisterCount++;
                     };
                 };
             };
             for(u32 x=0; x<proc->bodyCount; x++) lowerASTNode(proc->body[x], file);
             for(u32 x=0; x<REGS; x++) store(x, file);
-            file.areas.pop();
+            file.popArea();
             if(stackSize != 0) file.write("li x6, %d\nadd sp, sp, x6", stackSize);
         }break;
         case ASTType::DECLERATION:{
@@ -306,9 +321,9 @@ void lowerASTNode(ASTBase *node, ASMFile &file){
                     reg = getOrCreateFreeRegister(file);
                     file.write("addi x%d, x0, x0", reg+START_FREE_REG);
                 };
-                Area &curArea = file.areas[file.areas.count-1];
+                Area &curArea = file.areas[file.areaCount-1];
                 ASTVariable *var = (ASTVariable*)decl->lhs[0];
-                curArea.varToOff.insertValue(var->name, curArea.infos.count);
+                curArea.varToOff.insertValue(var->sym, curArea.infos.count);
                 VarInfo &info = curArea.infos.newElem();
                 info.fpOff = file.fpOff;
                 info.dw = (var->entity->size > 32 || var->entity->pointerDepth > 0) ? true:false;
@@ -316,7 +331,7 @@ void lowerASTNode(ASTBase *node, ASMFile &file){
                 Register &regi = file.regs[reg];
                 regi.fpOff = info.fpOff;
                 regi.dw = info.dw;
-                regi.gen = file.areas.count-1;
+                regi.gen = file.areaCount-1;
             }
         }break;
         case ASTType::ASSIGNMENT:{
@@ -326,7 +341,7 @@ void lowerASTNode(ASTBase *node, ASMFile &file){
             }else{
                 ASTVariable *var = (ASTVariable*)ass->lhs[0];
                 u32 rhs = lowerExpression(ass->rhs, file);
-                u32 lhs = getOrLoadToRegister(var->name, file);
+                u32 lhs = getOrLoadToRegister(var->sym, file);
                 file.write("add x%d, x0, x%d", lhs+START_FREE_REG, rhs+START_FREE_REG);
             };
         }break;
@@ -344,20 +359,21 @@ void lowerToRISCV(char *outputPath, DynamicArray<ASTBase*> &globals){
     char buff[BUFF_SIZE];
     char *start = ".section .data\n";
     u32 cursor = snprintf(buff, BUFF_SIZE, "%s", start);
-    for(u32 x=0,i=0; x<stringToId.count;){
-        if(stringToId.status[i]){
-            DUMP_STRINGS:
-            const String str = stringToId.keys[i];
-            u32 temp = snprintf(buff+cursor, BUFF_SIZE-cursor, "_L%d: .ascii \"%.*s\"\n", x, str.len, str.mem);
-            if(temp+cursor > BUFF_SIZE){
-                WRITE(file, buff, cursor);
-                cursor = 0;
-                goto DUMP_STRINGS;
-            };
-            cursor += temp;
-            x++;
+    //NOTE: the table is not in insertion order. The id is the label
+    String *strings = (String*)asmArena.alloc(sizeof(String)*stringToId.count);
+    for(u32 i=0; i<stringToId.len; i++){
+        if(stringToId.isFull(i)) strings[stringToId.values[i]] = stringToId.keys[i];
+    };
+    for(u32 x=0; x<stringToId.count; x++){
+        DUMP_STRINGS:
+        const String str = strings[x];
+        u32 temp = snprintf(buff+cursor, BUFF_SIZE-cursor, "_L%d: .ascii \"%.*s\"\n", x, str.len, str.mem);
+        if(temp+cursor > BUFF_SIZE){
+            WRITE(file, buff, cursor);
+            cursor = 0;
+            goto DUMP_STRINGS;
         };
-        i++;
+        cursor += temp;
     };
     globalToOff.init();
     globalInfos.init();
@@ -365,7 +381,7 @@ void lowerToRISCV(char *outputPath, DynamicArray<ASTBase*> &globals){
         ASTAssDecl *assdecl = (ASTAssDecl*)globals[x];
         ASTVariable *var = (ASTVariable*)assdecl->lhs[0];
         int temp;
-        globalToOff.insertValue(var->name, globalInfos.count);
+        globalToOff.insertValue(var->sym, globalInfos.count);
         VarInfo &info = globalInfos.newElem();
         info.fpOff = GLOBAL_IN_REG;
 GLOBAL_WRITE_ASM_TO_BUFF:
@@ -403,18 +419,19 @@ GLOBAL_WRITE_ASM_TO_BUFF:
     for(u32 x=linearDepEntities.count; x > 0;){
         x -= 1;
         FileEntity &fe = linearDepEntities[x];
-        if(fe.file.nodes.count == 0) continue;
         ASTFile &astFile = fe.file;
-        ASMFile AsmFile;
-        AsmFile.init();
-        for(u32 x=0; x<astFile.nodes.count; x++) lowerASTNode(astFile.nodes[x], AsmFile);
-        ASMBucket *buc = AsmFile.start;
-        AsmFile.uninit();
-        while(buc){
-            WRITE(file, buc->buff, strlen(buc->buff));
-            ASMBucket *temp = buc;
-            buc = buc->next;
-            mem::free(temp);
+        if(astFile.nodes.count != 0){
+            mem::ArenaMark fileMark = asmArena.mark();
+            ASMFile AsmFile;
+            AsmFile.init();
+            for(u32 x=0; x<astFile.nodes.count; x++) lowerASTNode(astFile.nodes[x], AsmFile);
+            for(ASMBucket *buc=AsmFile.start; buc; buc=buc->next){
+                WRITE(file, buc->buff, strlen(buc->buff));
+            };
+            asmArena.reset(fileMark);
         };
+        //last use of the file
+        astFile.uninit();
+        fe.lexer.releaseSource();
     };
 };